@@ -0,0 +1,236 @@
+#include <string.h>
+#include "batch.h"
+
+// All bits set in the lanes where a comparison holds, none elsewhere.
+// Comparing vectors already gives that, comparing scalars gives 1 or 0.
+#ifdef BATCH_VECTOR
+#define LANE_MASK(condition) ((Lanes) (condition))
+#else
+#define LANE_MASK(condition) ((Lanes) -(condition))
+#endif
+
+// Pick a where the mask is set and b everywhere else.
+static inline Lanes select_lanes(Lanes mask, Lanes a, Lanes b) {
+    return (a & mask) | (b & ~mask);
+}
+
+static inline bool any_lane(Lanes lanes) {
+#ifdef BATCH_VECTOR
+    uint64_t words[2];
+    memcpy(words, &lanes, sizeof(words));
+    return (words[0] | words[1]) != 0;
+#else
+    return lanes != 0;
+#endif
+}
+
+// The number of superpositions in every lane,
+// counted in parallel the same way as count_bits.
+static inline Lanes count_lane_bits(Lanes mask) {
+    mask = mask - ((mask >> 1) & (Tile) 0x55555555u);
+    mask = (mask & (Tile) 0x33333333u) + ((mask >> 2) & (Tile) 0x33333333u);
+    mask = (mask + (mask >> 4)) & (Tile) 0x0F0F0F0Fu;
+    for (unsigned int shift = 8; shift < sizeof(Tile) * 8; shift *= 2) mask = mask + (mask >> shift);
+    return mask & (Tile) 0xFF;
+}
+
+// Read or write the tile of a single board.
+static Tile get_board_tile(const Lanes *lanes, int board) {
+    Tile tile;
+    memcpy(&tile, (const char *) lanes + board * sizeof(Tile), sizeof(tile));
+    return tile;
+}
+
+static void set_board_tile(Lanes *lanes, int board, Tile tile) {
+    memcpy((char *) lanes + board * sizeof(Tile), &tile, sizeof(tile));
+}
+
+// The tile at a position in a house: the rows, then the columns, then the boxes.
+static int get_house_tile(int house, int position) {
+    if (house < BOARD_WIDTH) return house * BOARD_WIDTH + position;
+    if (house < BOARD_WIDTH * 2) return position * BOARD_WIDTH + house - BOARD_WIDTH;
+
+    int box = house - BOARD_WIDTH * 2;
+    int row = box / BOX_WIDTH * BOX_WIDTH + position / BOX_WIDTH;
+    int column = box % BOX_WIDTH * BOX_WIDTH + position % BOX_WIDTH;
+    return row * BOARD_WIDTH + column;
+}
+
+static void reset_board(Batch *batch, int board) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        set_board_tile(&batch->tiles[i][board / LANE_WIDTH], board % LANE_WIDTH, ALL_VALUES);
+    }
+}
+
+void reset_batch(Batch *batch, const Random *random) {
+    for (int board = 0; board < BATCH_SIZE; ++board) reset_board(batch, board);
+    batch->retired = 0;
+    batch->random = *random;
+    batch->restarts = 0;
+}
+
+// What a step found out about every board, as lanes that are
+// non-zero for a board when it holds,
+// and the houses that changed on any board since they were last swept.
+typedef struct StepState {
+    Lanes failed[BATCH_VECTORS];
+    Lanes open[BATCH_VECTORS];
+    bool dirty[HOUSE_COUNT];
+} StepState;
+
+// Mark the row, column and box of a tile to be swept again.
+static void mark_houses(StepState *state, int i) {
+    int row = i / BOARD_WIDTH;
+    int column = i % BOARD_WIDTH;
+    state->dirty[row] = true;
+    state->dirty[BOARD_WIDTH + column] = true;
+    state->dirty[BOARD_WIDTH * 2 + row / BOX_WIDTH * BOX_WIDTH + column / BOX_WIDTH] = true;
+}
+
+// Go through a house on every board at the same time.
+// Collapsed values are removed from the rest of the house,
+// and a value with only one place left in the house is collapsed there
+// (a hidden single), which is what the single board solver does with its
+// peer table and hidden singles pass, just without branching per board.
+static void sweep_house(Batch *batch, StepState *state, int h) {
+    // Which values appear in the house at least once, more than once,
+    // and collapsed (and collapsed twice, which is a contradiction).
+    Lanes once[BATCH_VECTORS] = { 0 }, twice[BATCH_VECTORS] = { 0 };
+    Lanes placed[BATCH_VECTORS] = { 0 }, clashes[BATCH_VECTORS] = { 0 };
+    for (int k = 0; k < BOARD_WIDTH; ++k) {
+        const Lanes *tile = batch->tiles[get_house_tile(h, k)];
+        for (int v = 0; v < BATCH_VECTORS; ++v) {
+            Lanes mask = tile[v];
+            Lanes single = mask & LANE_MASK((mask & (mask - 1)) == 0);
+            clashes[v] |= placed[v] & single;
+            placed[v] |= single;
+            twice[v] |= once[v] & mask;
+            once[v] |= mask;
+        }
+    }
+
+    // A value that's missing from a house can never be placed in it,
+    // which also catches tiles without any superpositions.
+    for (int v = 0; v < BATCH_VECTORS; ++v) {
+        state->failed[v] |= clashes[v] | (once[v] ^ ALL_VALUES);
+    }
+
+    for (int k = 0; k < BOARD_WIDTH; ++k) {
+        int i = get_house_tile(h, k);
+        Lanes *tile = batch->tiles[i];
+        Lanes changed = { 0 };
+        for (int v = 0; v < BATCH_VECTORS; ++v) {
+            Lanes mask = tile[v];
+            Lanes multiple = LANE_MASK((mask & (mask - 1)) != 0);
+            Lanes constrained = mask & ~(placed[v] & multiple);
+
+            Lanes hidden = constrained & once[v] & ~twice[v] & ~placed[v];
+            constrained = select_lanes(LANE_MASK(hidden != 0), hidden, constrained);
+
+            // Only a tile that's left with a single value (or none) changes
+            // what its other houses can remove. One that just lost a value
+            // can still leave a hidden single in them, but that's rare
+            // enough to leave to a later sweep, and sweeping the houses
+            // again for every one of them was most of the sweeps.
+            changed |= (mask ^ constrained) & LANE_MASK((constrained & (constrained - 1)) == 0);
+            tile[v] = constrained;
+        }
+        if (any_lane(changed)) mark_houses(state, i);
+    }
+}
+
+// Sweep the houses that changed until none of them change any more.
+// Tiles only ever lose superpositions, so this always stops,
+// and a board that fails once can't stop failing, so the failures
+// found along the way still hold for the boards as they are left.
+static void propagate_batch(Batch *batch, StepState *state) {
+    bool swept = true;
+    while (swept) {
+        swept = false;
+        for (int h = 0; h < HOUSE_COUNT; ++h) {
+            if (!state->dirty[h]) continue;
+            state->dirty[h] = false;
+            sweep_house(batch, state, h);
+            swept = true;
+        }
+    }
+
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        for (int v = 0; v < BATCH_VECTORS; ++v) {
+            Lanes mask = batch->tiles[i][v];
+            state->open[v] |= mask & (mask - 1);
+        }
+    }
+}
+
+// Collapse the tile with the least entropy on every board to a random value.
+static void collapse_batch(Batch *batch, StepState *state) {
+    // Finding the tiles works on every board at once,
+    // picking the values can only be done one board at a time.
+    Lanes best_entropy[BATCH_VECTORS], best_tile[BATCH_VECTORS];
+    for (int v = 0; v < BATCH_VECTORS; ++v) {
+        Lanes none = { 0 };
+        best_entropy[v] = none + (TILE_STATES + 1);
+        best_tile[v] = none;
+    }
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        Lanes tile = { 0 };
+        tile += (Tile) i;
+        for (int v = 0; v < BATCH_VECTORS; ++v) {
+            Lanes entropy = count_lane_bits(batch->tiles[i][v]);
+            Lanes better = LANE_MASK(entropy > 1) & LANE_MASK(entropy < best_entropy[v]);
+            best_entropy[v] = select_lanes(better, entropy, best_entropy[v]);
+            best_tile[v] = select_lanes(better, tile, best_tile[v]);
+        }
+    }
+
+    for (int board = 0; board < BATCH_SIZE; ++board) {
+        int entropy = get_board_tile(&best_entropy[board / LANE_WIDTH], board % LANE_WIDTH);
+        int i = get_board_tile(&best_tile[board / LANE_WIDTH], board % LANE_WIDTH);
+
+        // Boards without open tiles are always retired by the step before.
+        if (entropy > TILE_STATES) continue;
+
+        Lanes *lanes = &batch->tiles[i][board / LANE_WIDTH];
+        unsigned int mask = get_board_tile(lanes, board % LANE_WIDTH);
+        for (int skip = get_random_value(&batch->random, 0, entropy - 1); skip; --skip) {
+            mask &= mask - 1;
+        }
+        set_board_tile(lanes, board % LANE_WIDTH, (Tile) (1u << lowest_bit(mask)));
+        mark_houses(state, i);
+    }
+}
+
+uint32_t step_batch(Batch *batch) {
+    for (int board = 0; board < BATCH_SIZE; ++board) {
+        if (batch->retired & (1u << board)) reset_board(batch, board);
+    }
+
+    StepState state;
+    memset(&state, 0, sizeof(state));
+    collapse_batch(batch, &state);
+    propagate_batch(batch, &state);
+
+    uint32_t solved = 0;
+    batch->retired = 0;
+    for (int board = 0; board < BATCH_SIZE; ++board) {
+        const Lanes *failed = &state.failed[board / LANE_WIDTH];
+        const Lanes *open = &state.open[board / LANE_WIDTH];
+
+        if (get_board_tile(failed, board % LANE_WIDTH)) {
+            batch->retired |= 1u << board;
+            ++batch->restarts;
+        } else if (!get_board_tile(open, board % LANE_WIDTH)) {
+            batch->retired |= 1u << board;
+            solved |= 1u << board;
+        }
+    }
+    return solved;
+}
+
+void get_batch_values(const Batch *batch, int board, uint8_t values[BOARD_SIZE]) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        Tile tile = get_board_tile(&batch->tiles[i][board / LANE_WIDTH], board % LANE_WIDTH);
+        values[i] = (uint8_t) lowest_bit(tile);
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "wfc.h"
+
+// The number of boards a batch advances at the same time.
+// Every tile is stored for all of them next to each other,
+// so with 16-bit tiles a batch of 16 is two 128-bit vectors per tile.
+#ifndef BATCH_SIZE
+#define BATCH_SIZE (16)
+#endif
+
+// Lanes hold the same tile of several boards, one board per lane.
+// GCC and Clang can do arithmetic on 128-bit vector types directly,
+// which compiles to SSE2 on x86 and NEON on ARM,
+// so the solver is written once for both. Other compilers
+// (or -DBATCH_SCALAR) get one board per lane and a loop instead.
+#if !defined(BATCH_SCALAR) && (defined(__GNUC__) || defined(__clang__))
+#define LANE_WIDTH ((int) (16 / sizeof(Tile)))
+typedef Tile Lanes __attribute__((vector_size(16)));
+#define BATCH_VECTOR
+#define BATCH_KERNEL "vector"
+#else
+#define LANE_WIDTH (1)
+typedef Tile Lanes;
+#define BATCH_KERNEL "scalar"
+#endif
+
+#define BATCH_VECTORS (BATCH_SIZE / LANE_WIDTH)
+
+// Fails to compile if the boards don't fill the vectors exactly,
+// or don't fit in the masks step_batch returns.
+typedef char batch_size_check[BATCH_SIZE % LANE_WIDTH == 0 && BATCH_SIZE <= 32 ? 1 : -1];
+
+// A batch of boards laid out as a structure of arrays:
+// tiles[i] holds tile i of every board in the batch,
+// so working through the tiles works on every board at once.
+//
+// The boards are solved without backtracking. Every step collapses one
+// tile on every board and propagates it; a board that runs into a
+// contradiction is started again from scratch instead of being rolled back,
+// because rolling back one board would stop the rest moving in lockstep.
+//
+// It's slower than solve_board, which only propagates to the peers of what
+// it collapsed, while every step here sweeps whole houses on every board.
+// By how much depends on the machine, the bench prints the ratio.
+typedef struct Batch {
+    Lanes tiles[BOARD_SIZE][BATCH_VECTORS];
+
+    // The boards that were solved or failed on the last step,
+    // which are reset at the start of the next one.
+    uint32_t retired;
+
+    Random random;
+
+    // The number of boards that had to be started again.
+    long restarts;
+} Batch;
+
+// Reset every board in the batch. The random number generator
+// is copied into the batch to pick the values tiles are collapsed to.
+void reset_batch(Batch *batch, const Random *random);
+
+// Collapse one tile on every board in the batch and propagate it.
+// Returns a bit mask of the boards that were solved by this step,
+// which can be read until the next step starts them again.
+uint32_t step_batch(Batch *batch);
+
+// Get the collapsed value (0-8) of every tile of a board in the batch.
+void get_batch_values(const Batch *batch, int board, uint8_t values[BOARD_SIZE]);
+
+#endif // BATCH_H
@@ -0,0 +1,645 @@
+// clock_gettime is POSIX, not C99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "batch.h"
+#include "bitboard.h"
+#include "dlx.h"
+#include "libsudoku_wfc.h"
+#include "portfolio.h"
+#include "puzzles.h"
+#include "wfc.h"
+
+// Microbenchmarks for the solver's innermost operations,
+// each one timed against the implementation it replaced,
+// and then the whole solver on fixed workloads: empty boards, a set of
+// 17 clue puzzles, and any puzzle files given with -i.
+// Every workload is seeded the same way on every run, so the numbers
+// of two builds can be compared, which -j makes easier by writing
+// them all to a JSON file as well.
+
+#define MASK_COUNT (1 << 16)
+#define MASK_ROUNDS (1000)
+
+#define SEED (42)
+#define SOLVE_COUNT (20000)
+
+static double get_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Every result is printed as it's measured, and kept for -j.
+#define MAX_RESULTS (64)
+#define MAX_METRICS (6)
+typedef struct Result {
+    char name[64];
+    int metric_count;
+    const char *keys[MAX_METRICS];
+    double values[MAX_METRICS];
+} Result;
+
+static Result results[MAX_RESULTS];
+static int result_count = 0;
+
+static Result *add_result(const char *name) {
+    // Anything past the last result is measured, just not kept.
+    static Result dropped;
+    Result *result = result_count < MAX_RESULTS ? &results[result_count++] : &dropped;
+    *result = (Result) { 0 };
+    snprintf(result->name, sizeof(result->name), "%s", name);
+    return result;
+}
+
+static void add_metric(Result *result, const char *key, double value) {
+    if (result->metric_count == MAX_METRICS) return;
+    result->keys[result->metric_count] = key;
+    result->values[result->metric_count++] = value;
+}
+
+static bool write_results(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+
+    fprintf(out, "{\n  \"board_order\": %d,\n", BOARD_ORDER);
+    fprintf(out, "  \"bitboard_kernel\": \"%s\",\n", BITBOARD_KERNEL);
+    fprintf(out, "  \"batch_kernel\": \"%s\",\n", BATCH_KERNEL);
+    fprintf(out, "  \"results\": [");
+    for (int i = 0; i < result_count; ++i) {
+        const Result *result = &results[i];
+        fprintf(out, "%s\n    {\"name\": \"%s\"", i ? "," : "", result->name);
+        for (int k = 0; k < result->metric_count; ++k) {
+            fprintf(out, ", \"%s\": %.6g", result->keys[k], result->values[k]);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ]\n}\n");
+
+    bool failed = ferror(out);
+    return fclose(out) == 0 && !failed;
+}
+
+// get_tile_entropy before it used count_values.
+static int loop_entropy(unsigned int mask) {
+    int entropy = 0;
+    for (int i = 0; i < TILE_STATES; ++i) {
+        entropy += (mask >> i) & 1;
+    }
+    return entropy;
+}
+
+// get_collapsed_value before it used lowest_bit.
+static int log2_value(unsigned int mask) {
+    return (int) log2(mask & ((1 << TILE_STATES) - 1));
+}
+
+static unsigned int masks[MASK_COUNT];
+static unsigned int collapsed_masks[MASK_COUNT];
+
+// Results are accumulated here so the compiler can't skip the work.
+static volatile long sink;
+
+// Defines a function that returns the average time in nanoseconds
+// of one call to `function` on the input masks.
+// It's a macro so that the call can be inlined, like it is in the solver.
+// Each result picks the next mask, which keeps the compiler from
+// vectorizing the loop (the solver only ever looks at one tile at a time).
+#define DEFINE_MASK_TIMER(name, function)                                   \
+    static double name(const unsigned int *input) {                         \
+        int index = 0;                                                      \
+        double start = get_time();                                          \
+        for (long i = 0; i < (long) MASK_ROUNDS * MASK_COUNT; ++i) {        \
+            index = (index + 1 + function(input[index])) & (MASK_COUNT - 1); \
+        }                                                                   \
+        double elapsed = get_time() - start;                                \
+        sink = index;                                                       \
+        return elapsed * 1e9 / ((double) MASK_ROUNDS * MASK_COUNT);         \
+    }
+
+DEFINE_MASK_TIMER(time_loop_entropy, loop_entropy)
+DEFINE_MASK_TIMER(time_count_values, count_values)
+DEFINE_MASK_TIMER(time_log2_value, log2_value)
+DEFINE_MASK_TIMER(time_lowest_bit, lowest_bit)
+
+// is_collapsed before the entropy was cached next to each tile.
+static bool counted_is_collapsed(Board *board, int x, int y) {
+    return loop_entropy((unsigned int) *get_tile(board, x, y)) == 1;
+}
+
+// get_tile_entropy by the index of a tile, the way the solver calls it,
+// against counting the tile's bits every time like it used to.
+static int counted_tile_entropy(Board *board, int x, int y) {
+    return loop_entropy((unsigned int) *get_tile(board, x, y));
+}
+
+static int cached_tile_entropy(Board *board, int x, int y) {
+    return get_tile_entropy(board, y * BOARD_WIDTH + x);
+}
+
+// get_lowest_entropy_tile before the buckets:
+// sort every tile by entropy, and take the first one that isn't collapsed.
+static int sorted_lowest_entropy_tile(Board *board) {
+    int sorted_tiles[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; ++i) sorted_tiles[i] = i;
+
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        for (int j = i + 1; j < BOARD_SIZE; ++j) {
+            int a = get_tile_entropy(board, sorted_tiles[i]);
+            int b = get_tile_entropy(board, sorted_tiles[j]);
+            if (a <= b) continue;
+
+            int temp = sorted_tiles[i];
+            sorted_tiles[i] = sorted_tiles[j];
+            sorted_tiles[j] = temp;
+        }
+    }
+
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (get_tile_entropy(board, sorted_tiles[i]) > 1) return sorted_tiles[i];
+    }
+    return -1;
+}
+
+// Defines a function that times `function` on the tiles of a board,
+// the same way DEFINE_MASK_TIMER does for masks.
+#define DEFINE_TILE_TIMER(name, function)                                   \
+    static double name(Board *board) {                                      \
+        int index = 0;                                                      \
+        double start = get_time();                                          \
+        for (long i = 0; i < (long) MASK_ROUNDS * MASK_COUNT; ++i) {        \
+            int x = index % BOARD_WIDTH;                                    \
+            int y = index / BOARD_WIDTH;                                    \
+            index = (index + 1 + function(board, x, y)) % BOARD_SIZE;       \
+        }                                                                   \
+        double elapsed = get_time() - start;                                \
+        sink = index;                                                       \
+        return elapsed * 1e9 / ((double) MASK_ROUNDS * MASK_COUNT);         \
+    }
+
+DEFINE_TILE_TIMER(time_counted_is_collapsed, counted_is_collapsed)
+DEFINE_TILE_TIMER(time_is_collapsed, is_collapsed)
+DEFINE_TILE_TIMER(time_counted_tile_entropy, counted_tile_entropy)
+DEFINE_TILE_TIMER(time_cached_tile_entropy, cached_tile_entropy)
+
+// Boards at different stages of being solved, for the timers that look at
+// a whole board. Going through several keeps the compiler from noticing
+// that the same board gives the same answer every time.
+#define STAGE_COUNT (8)
+static Board stages[STAGE_COUNT];
+
+// Defines a function that returns the average time in nanoseconds
+// of one call to `function` on the stages.
+#define DEFINE_BOARD_TIMER(name, function, rounds)                          \
+    static double name(void) {                                              \
+        long total = 0;                                                     \
+        double start = get_time();                                          \
+        for (long i = 0; i < (long) (rounds); ++i) {                        \
+            total += function(&stages[i % STAGE_COUNT]);                    \
+        }                                                                   \
+        double elapsed = get_time() - start;                                \
+        sink = total;                                                       \
+        return elapsed * 1e9 / (double) (rounds);                           \
+    }
+
+DEFINE_BOARD_TIMER(time_sorted_selection, sorted_lowest_entropy_tile, 100000)
+DEFINE_BOARD_TIMER(time_bucket_selection, get_lowest_entropy_tile, 10000000)
+
+static void compare(const char *name, double old_ns, double new_ns) {
+    printf("%-20s %8.3f ns -> %8.3f ns (%.2fx)\n", name, old_ns, new_ns, old_ns / new_ns);
+
+    Result *result = add_result(name);
+    add_metric(result, "old_ns", old_ns);
+    add_metric(result, "new_ns", new_ns);
+}
+
+static void report_time(const char *name, double ns) {
+    printf("%-20s %8.3f ns\n", name, ns);
+    add_metric(add_result(name), "ns", ns);
+}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Report the throughput of a workload, and the latency percentiles
+// of its solves (which are sorted in place). Returns the throughput,
+// which is 0 if there weren't any.
+static double report_solves(const char *name, double *latencies, int solves, double elapsed, long backtracks) {
+    if (solves == 0) {
+        printf("%-20s no boards\n", name);
+        return 0;
+    }
+
+    qsort(latencies, (size_t) solves, sizeof(double), compare_doubles);
+    double p50 = latencies[(solves - 1) * 50 / 100] * 1e9;
+    double p99 = latencies[(solves - 1) * 99 / 100] * 1e9;
+    double p999 = latencies[(int) ((solves - 1) * 999L / 1000)] * 1e9;
+
+    printf(
+        "%-20s %8.0f boards/s, %.3f backtracks/board, p50 %.0f ns, p99 %.0f ns, p99.9 %.0f ns\n",
+        name, solves / elapsed, backtracks / (double) solves, p50, p99, p999
+    );
+
+    Result *result = add_result(name);
+    add_metric(result, "boards_per_second", solves / elapsed);
+    add_metric(result, "backtracks_per_board", backtracks / (double) solves);
+    add_metric(result, "p50_ns", p50);
+    add_metric(result, "p99_ns", p99);
+    add_metric(result, "p999_ns", p999);
+    return solves / elapsed;
+}
+
+static double latencies[SOLVE_COUNT];
+
+// Returns the boards per second.
+static double time_solve(const char *name, Board *board, unsigned int passes) {
+    Random random;
+    seed_random(&random, SEED, 0);
+    long backtracks = 0;
+    board->passes = passes;
+
+    double start = get_time();
+    for (int i = 0; i < SOLVE_COUNT; ++i) {
+        double solve_start = get_time();
+        reset_tiles(board);
+        solve_board(board, &random);
+        latencies[i] = get_time() - solve_start;
+        backtracks += board->backtracks;
+    }
+    double elapsed = get_time() - start;
+
+    return report_solves(name, latencies, SOLVE_COUNT, elapsed, backtracks);
+}
+
+// Solve a set of puzzles over and over, until `solves` of them have been
+// solved (at most SOLVE_COUNT, the same number of latencies as time_solve).
+// Loading a puzzle counts, since its givens are propagated then.
+static void time_puzzles(const char *name, Board *board, const char *const *puzzles, int puzzle_count, int solves, unsigned int passes) {
+    Random random;
+    seed_random(&random, SEED, 0);
+    long backtracks = 0;
+    board->passes = passes;
+
+    double start = get_time();
+    for (int i = 0; i < solves; ++i) {
+        const char *puzzle = puzzles[i % puzzle_count];
+        double solve_start = get_time();
+        if (load_puzzle(board, puzzle, strcspn(puzzle, "\r\n"))) solve_board(board, &random);
+        latencies[i] = get_time() - solve_start;
+        backtracks += board->backtracks;
+    }
+    double elapsed = get_time() - start;
+
+    report_solves(name, latencies, solves, elapsed, backtracks);
+}
+
+// The same as time_puzzles, but racing every puzzle on racers threads
+// (see portfolio.h) from the start, so the latencies are how long the
+// first of the racers takes. Which one that is depends on timing,
+// so unlike the other workloads this one isn't the same on every run.
+static void time_races(const char *name, Board *board, const char *const *puzzles, int puzzle_count, int solves, int racers) {
+    Random random;
+    seed_random(&random, SEED, 0);
+    long backtracks = 0;
+    board->passes = 0;
+
+    double start = get_time();
+    for (int i = 0; i < solves; ++i) {
+        const char *puzzle = puzzles[i % puzzle_count];
+        uint8_t values[BOARD_SIZE];
+        Solution solution;
+        SolveState solve;
+        double solve_start = get_time();
+        if (read_puzzle(puzzle, strcspn(puzzle, "\r\n"), values) && set_puzzle(board, values)
+            && start_solve(board, &solve) == SOLVE_RUNNING) {
+            race_solve(board, &solve, &random, values, racers, SEED + (uint64_t) i, &solution);
+        }
+        latencies[i] = get_time() - solve_start;
+        backtracks += board->backtracks;
+    }
+    double elapsed = get_time() - start;
+
+    report_solves(name, latencies, solves, elapsed, backtracks);
+}
+
+// Time an engine (see dlx.h) on a class of boards: empty boards without
+// any puzzles, or else the puzzles. With a limit the solutions are only
+// counted up to it, which is what it takes to check that a puzzle is unique.
+// Returns the boards per second.
+static double time_engine(const char *name, int engine, Board *board, const char *const *puzzles, int puzzle_count, int solves, int limit) {
+    static DlxSolver dlx;
+    Random random;
+    seed_random(&random, SEED, 0);
+    long backtracks = 0;
+    board->passes = 0;
+
+    // A puzzle whose givens contradict each other is skipped,
+    // so only the boards that were solved are reported.
+    int timed = 0;
+    double start = get_time();
+    for (int i = 0; i < solves; ++i) {
+        const char *puzzle = puzzle_count ? puzzles[i % puzzle_count] : NULL;
+        double solve_start = get_time();
+        if (puzzle && !load_puzzle(board, puzzle, strcspn(puzzle, "\r\n"))) continue;
+        if (!puzzle) reset_tiles(board);
+
+        if (limit) {
+            count_with_engine(engine, &dlx, board, limit);
+        } else {
+            solve_with_engine(engine, &dlx, board, &random);
+            backtracks += board->backtracks;
+        }
+        latencies[timed++] = get_time() - solve_start;
+    }
+    double elapsed = get_time() - start;
+
+    return report_solves(name, latencies, timed, elapsed, backtracks);
+}
+
+// Time every engine on a class of boards, and report the fastest of the
+// ones that aren't ENGINE_AUTO, which should be about as fast as it.
+static void pick_engine(const char *name, Board *board, const char *const *puzzles, int puzzle_count, int solves, int limit) {
+    int fastest = 0;
+    double fastest_rate = 0;
+    for (int engine = 0; engine < ENGINE_COUNT; ++engine) {
+        char engine_name[64];
+        snprintf(engine_name, sizeof(engine_name), "%s, %s", name, get_engine_name(engine));
+        double rate = time_engine(engine_name, engine, board, puzzles, puzzle_count, solves, limit);
+        if (engine != ENGINE_AUTO && rate > fastest_rate) {
+            fastest = engine;
+            fastest_rate = rate;
+        }
+    }
+
+    char result_name[64];
+    snprintf(result_name, sizeof(result_name), "fastest for %s", name);
+    printf("%-20s %s\n", result_name, get_engine_name(fastest));
+    add_metric(add_result(result_name), "engine", fastest);
+}
+
+// The library's batch call (see libsudoku_wfc.h) on the puzzles, repeated
+// until there are `solves` of them, read and written in place in one call.
+// There's only the throughput, which is what the call is for.
+static void time_library_batch(const char *name, const char *const *puzzles, int puzzle_count, int solves) {
+    uint8_t *values = malloc((size_t) solves * BOARD_SIZE * 2);
+    if (!values) return;
+
+    for (int i = 0; i < solves; ++i) {
+        const char *puzzle = puzzles[i % puzzle_count];
+        read_puzzle(puzzle, strcspn(puzzle, "\r\n"), values + (size_t) i * BOARD_SIZE);
+    }
+
+    double start = get_time();
+    long solved = sudoku_solve_batch(values, (size_t) solves, values + (size_t) solves * BOARD_SIZE, 0);
+    double elapsed = get_time() - start;
+    free(values);
+
+    printf("%-20s %8.0f boards/s, %ld solved\n", name, solves / elapsed, solved);
+    add_metric(add_result(name), "boards_per_second", solves / elapsed);
+}
+
+// The same as time_solve, but BATCH_SIZE boards at a time,
+// so there's only the throughput, which is compared with the single board
+// solver's (single_rate) since that's the one it has to beat.
+static void time_batch(const char *name, double single_rate) {
+    static Batch batch;
+    Random random;
+    seed_random(&random, SEED, 0);
+    reset_batch(&batch, &random);
+
+    double start = get_time();
+    for (int solved = 0; solved < SOLVE_COUNT;) solved += count_bits(step_batch(&batch));
+    double elapsed = get_time() - start;
+
+    printf(
+        "%-20s %8.0f boards/s, %.3f restarts/board (%.2fx solve board)\n",
+        name, SOLVE_COUNT / elapsed, batch.restarts / (double) SOLVE_COUNT, SOLVE_COUNT / elapsed / single_rate
+    );
+
+    Result *result = add_result(name);
+    add_metric(result, "boards_per_second", SOLVE_COUNT / elapsed);
+    add_metric(result, "restarts_per_board", batch.restarts / (double) SOLVE_COUNT);
+    add_metric(result, "speedup", SOLVE_COUNT / elapsed / single_rate);
+}
+
+#if BOARD_ORDER == 3
+// Puzzles with 17 givens, the fewest a 9x9 puzzle with a unique solution can
+// have, which leaves the most for the search to do.
+static const char *const hard17[] = {
+    "000000010400000000020000000000050407008000300001090000300400200050100000000806000",
+    "000000010400000000020000000000050604008000300001090000300400200050100000000807000",
+    "000000012000035000000600070700000300000400800100000000000120000080000040050000600",
+    "000000012003600000000007000410020000000500300700000600280000040000300500000000000",
+    "000000012008030000000000040120500000000004700060000000507000300000620000000100000",
+    "000000012040050000000009000070600400000100000000000050000087500601000300200000000",
+    "000000012050400000000000030700600400001000000000080000920000800000510700000003000",
+    "000000012300000060000040000900000500000001070020000000000350400001400800060000000",
+    "000000012400090000000000050070200000600000400000108000018000000000030700502000000",
+    "000000012500008000000700000600120000700000450000030000030000800000500700020000000",
+    "000000013000030080070000000000206000030000900000010000600500204000400700100000000",
+    "000000013000200000000000080000760200008000400010000000200000750600340000000008000",
+    "000000013000500070000802000000400900107000000000000200890000050040000600000010000",
+    "000000013000700060000508000000400800106000000000000200740000050020000400000010000",
+    "000000013000800070000502000000400900107000000000000200890000050040000600000010000",
+    "000000013020500000000000000103000070000802000004000000000340500670000200000010000",
+    "000000013040000080200060000609000400000800000000300000030100500000040706000000000",
+    "000000013040000080200060000906000400000800000000300000030100500000040706000000000",
+};
+#endif
+
+// Time the puzzles of a file, named after the file.
+// Returns false if it can't be read, or has no puzzles.
+static bool time_puzzle_file(const char *path, Board *board) {
+    PuzzleFile file;
+    if (!open_puzzles(&file, path)) return false;
+
+    // The lines are pointed to right in the mapping.
+    long line_count = 0;
+    for (size_t i = 0; i < file.size; ++i) line_count += file.data[i] == '\n';
+    const char **lines = malloc((size_t) (line_count + 1) * sizeof(char *));
+    if (!lines) {
+        close_puzzles(&file);
+        return false;
+    }
+
+    int puzzle_count = 0;
+    for (const char *line = file.data, *end = file.data + file.size; line < end;) {
+        const char *newline = memchr(line, '\n', (size_t) (end - line));
+        size_t length = (size_t) ((newline ? newline : end) - line);
+        if (length && line[length - 1] == '\r') --length;
+        if (length == BOARD_SIZE) lines[puzzle_count++] = line;
+        line = newline ? newline + 1 : end;
+    }
+
+    if (puzzle_count) {
+        char name[64];
+        const char *base = strrchr(path, '/');
+        snprintf(name, sizeof(name), "file %s", base ? base + 1 : path);
+        time_puzzles(name, board, lines, puzzle_count, SOLVE_COUNT, PASS_ALL);
+    }
+
+    free(lines);
+    close_puzzles(&file);
+    return puzzle_count > 0;
+}
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+        "Usage: %s [-i file]... [-j file]\n"
+        "  -i file  Also time the puzzles in a file, one per line\n"
+        "  -j file  Write the results to a file as JSON\n",
+        program
+    );
+}
+
+int main(int argc, char **argv) {
+    const char *puzzle_paths[16];
+    int puzzle_path_count = 0;
+    const char *json_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && strcmp(argv[i], "-i") == 0 && puzzle_path_count < 16) {
+            puzzle_paths[puzzle_path_count++] = argv[++i];
+        } else if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+            json_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    Random random;
+    seed_random(&random, SEED, 0);
+
+    for (int i = 0; i < MASK_COUNT; ++i) {
+        masks[i] = (unsigned int) get_random_value(&random, 0, (1 << TILE_STATES) - 1);
+        collapsed_masks[i] = 1u << get_random_value(&random, 0, TILE_STATES - 1);
+    }
+
+    printf("bitboard kernel: %s, batch kernel: %s\n", BITBOARD_KERNEL, BATCH_KERNEL);
+    compare("tile entropy", time_loop_entropy(masks), time_count_values(masks));
+    compare("collapsed value", time_log2_value(collapsed_masks), time_lowest_bit(collapsed_masks));
+
+    // A partially collapsed board, so is_collapsed sees a mix of tiles.
+    Board board = { 0 };
+    reset_tiles(&board);
+    for (int i = 0; i < BOARD_SIZE; i += 3) {
+        int x = i % BOARD_WIDTH;
+        int y = i / BOARD_WIDTH;
+        if (!is_collapsed(&board, x, y) && get_tile_entropy(&board, i) > 0) {
+            collapse_tile(&board, x, y, lowest_bit((unsigned int) *get_tile(&board, x, y)));
+        }
+    }
+    compare("is collapsed", time_counted_is_collapsed(&board), time_is_collapsed(&board));
+    compare("get tile entropy", time_counted_tile_entropy(&board), time_cached_tile_entropy(&board));
+
+    // Stage k has about k / STAGE_COUNT of its tiles collapsed,
+    // the way a board is on its way to being solved.
+    for (int k = 0; k < STAGE_COUNT; ++k) {
+        reset_tiles(&stages[k]);
+        for (int i = 0; i < BOARD_SIZE * k / STAGE_COUNT; ++i) {
+            int tile = get_lowest_entropy_tile(&stages[k]);
+            if (tile < 0) break;
+
+            int x = tile % BOARD_WIDTH;
+            int y = tile / BOARD_WIDTH;
+            int trail_size = stages[k].trail_size;
+            if (!collapse_tile(&stages[k], x, y, lowest_bit((unsigned int) *get_tile(&stages[k], x, y)))) {
+                rollback_tiles(&stages[k], trail_size);
+                break;
+            }
+        }
+    }
+    compare("tile selection", time_sorted_selection(), time_bucket_selection());
+
+    // Collapsing a tile on an empty board constrains each of its peers
+    // without cascading any further, which isolates constrain_peers.
+    reset_tiles(&board);
+    int collapses = 1000000;
+    double collapse_start = get_time();
+    for (int i = 0; i < collapses; ++i) {
+        int tile = i % BOARD_SIZE;
+        collapse_tile(&board, tile % BOARD_WIDTH, tile / BOARD_WIDTH, i % TILE_STATES);
+        rollback_tiles(&board, 0);
+    }
+    double collapse_ns = (get_time() - collapse_start) * 1e9 / collapses;
+    report_time("collapse tile", collapse_ns);
+
+    // The same without setting the tile first, which is only constrain_peers.
+    double constrain_start = get_time();
+    for (int i = 0; i < collapses; ++i) {
+        int tile = i % BOARD_SIZE;
+        constrain_peers(&board, tile % BOARD_WIDTH, tile / BOARD_WIDTH, i % TILE_STATES);
+        rollback_tiles(&board, 0);
+    }
+    report_time("constrain peers", (get_time() - constrain_start) * 1e9 / collapses);
+
+    // Time the whole solver, since that's what the operations are for.
+    double single_rate = time_solve("solve board", &board, 0);
+    time_solve("hidden singles", &board, PASS_HIDDEN_SINGLES);
+    time_solve("naked pairs", &board, PASS_NAKED_PAIRS);
+    time_solve("pointing pairs", &board, PASS_POINTING_PAIRS);
+    time_solve("all passes", &board, PASS_ALL);
+    time_batch("batch", single_rate);
+
+#if BOARD_ORDER == 3
+    int hard_count = (int) (sizeof(hard17) / sizeof(hard17[0]));
+    time_puzzles("17 clues", &board, hard17, hard_count, SOLVE_COUNT, 0);
+    time_puzzles("17 clues, all passes", &board, hard17, hard_count, SOLVE_COUNT, PASS_ALL);
+
+    // Racer 0 solves the puzzles the same way as above, so on a single
+    // core this mostly shows what starting the races costs.
+    char race_name[64];
+    snprintf(race_name, sizeof(race_name), "17 clues, raced on %d", get_core_count());
+    time_races(race_name, &board, hard17, hard_count, SOLVE_COUNT / 10, get_core_count());
+    time_library_batch("17 clues, library", hard17, hard_count, SOLVE_COUNT);
+#endif
+
+    // Every combination of the heuristics, without any passes
+    // so the heuristics do all of the work. The 17 clue puzzles take
+    // far longer to solve, so they only get a tenth of the solves.
+    for (int selection = 0; selection < SELECTION_COUNT; ++selection) {
+        for (int ordering = 0; ordering < ORDERING_COUNT; ++ordering) {
+            char name[64];
+            board.selection = selection;
+            board.ordering = ordering;
+
+            snprintf(name, sizeof(name), "%s + %s", get_selection_name(selection), get_ordering_name(ordering));
+            time_solve(name, &board, 0);
+#if BOARD_ORDER == 3
+            snprintf(name, sizeof(name), "17 clues, %s + %s", get_selection_name(selection), get_ordering_name(ordering));
+            time_puzzles(name, &board, hard17, hard_count, SOLVE_COUNT / 10, 0);
+#endif
+        }
+    }
+    board.selection = SELECT_MRV;
+    board.ordering = ORDER_RANDOM;
+
+    // Each engine on each class of boards. Exact cover is slower to set up
+    // but takes far fewer steps, so it depends on how much searching there is.
+    pick_engine("empty boards", &board, NULL, 0, SOLVE_COUNT / 10, 0);
+#if BOARD_ORDER == 3
+    pick_engine("17 clues", &board, hard17, hard_count, SOLVE_COUNT / 20, 0);
+    pick_engine("17 clues, unique", &board, hard17, hard_count, SOLVE_COUNT / 100, 2);
+#endif
+
+    bool timed = true;
+    for (int i = 0; i < puzzle_path_count; ++i) {
+        if (!time_puzzle_file(puzzle_paths[i], &board)) {
+            fprintf(stderr, "No puzzles to time in %s\n", puzzle_paths[i]);
+            timed = false;
+        }
+    }
+
+    if (json_path && !write_results(json_path)) {
+        perror(json_path);
+        return 1;
+    }
+    return !timed;
+}
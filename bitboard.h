@@ -0,0 +1,97 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "wfc.h"
+
+// Operations on bitboards, one 128-bit lane at a time.
+// The kernel is picked at compile time: SSE2 on x86, NEON on ARM,
+// and plain 64-bit words everywhere else (or with -DBITBOARD_SCALAR).
+// Bitboards are always stored as words, so only these functions change.
+
+#if !defined(BITBOARD_SCALAR) && (defined(__SSE2__) || defined(_M_X64))
+#define BITBOARD_SSE2
+#include <emmintrin.h>
+#elif !defined(BITBOARD_SCALAR) && (defined(__ARM_NEON) || defined(__aarch64__))
+#define BITBOARD_NEON
+#include <arm_neon.h>
+#endif
+
+// The name of the kernel that was compiled in, for reporting.
+#if defined(BITBOARD_SSE2)
+#define BITBOARD_KERNEL "sse2"
+#elif defined(BITBOARD_NEON)
+#define BITBOARD_KERNEL "neon"
+#else
+#define BITBOARD_KERNEL "scalar"
+#endif
+
+static inline int count_bits64(uint64_t mask) {
+    return count_bits((unsigned int) mask) + count_bits((unsigned int) (mask >> 32));
+}
+
+static inline int lowest_bit64(uint64_t mask) {
+    unsigned int low = (unsigned int) mask;
+    return low ? lowest_bit(low) : 32 + lowest_bit((unsigned int) (mask >> 32));
+}
+
+// a & b
+static inline Bitboard bitboard_and(const Bitboard *a, const Bitboard *b) {
+    Bitboard result;
+    for (int lane = 0; lane < BITBOARD_LANES; ++lane) {
+        const uint64_t *x = &a->words[lane * 2];
+        const uint64_t *y = &b->words[lane * 2];
+        uint64_t *out = &result.words[lane * 2];
+#if defined(BITBOARD_SSE2)
+        __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i *) x), _mm_loadu_si128((const __m128i *) y));
+        _mm_storeu_si128((__m128i *) out, v);
+#elif defined(BITBOARD_NEON)
+        vst1q_u64(out, vandq_u64(vld1q_u64(x), vld1q_u64(y)));
+#else
+        out[0] = x[0] & y[0];
+        out[1] = x[1] & y[1];
+#endif
+    }
+    return result;
+}
+
+// a & ~b
+static inline Bitboard bitboard_and_not(const Bitboard *a, const Bitboard *b) {
+    Bitboard result;
+    for (int lane = 0; lane < BITBOARD_LANES; ++lane) {
+        const uint64_t *x = &a->words[lane * 2];
+        const uint64_t *y = &b->words[lane * 2];
+        uint64_t *out = &result.words[lane * 2];
+#if defined(BITBOARD_SSE2)
+        // _mm_andnot_si128 negates its first argument.
+        __m128i v = _mm_andnot_si128(_mm_loadu_si128((const __m128i *) y), _mm_loadu_si128((const __m128i *) x));
+        _mm_storeu_si128((__m128i *) out, v);
+#elif defined(BITBOARD_NEON)
+        vst1q_u64(out, vbicq_u64(vld1q_u64(x), vld1q_u64(y)));
+#else
+        out[0] = x[0] & ~y[0];
+        out[1] = x[1] & ~y[1];
+#endif
+    }
+    return result;
+}
+
+// The number of tiles in the set.
+static inline int bitboard_count(const Bitboard *a) {
+    int count = 0;
+    for (int word = 0; word < BITBOARD_LANES * 2; ++word) count += count_bits64(a->words[word]);
+    return count;
+}
+
+// The lowest tile in the set, or -1 if it's empty.
+static inline int bitboard_first(const Bitboard *a) {
+    for (int word = 0; word < BITBOARD_LANES * 2; ++word) {
+        if (a->words[word]) return word * 64 + lowest_bit64(a->words[word]);
+    }
+    return -1;
+}
+
+static inline void bitboard_set(Bitboard *a, int tile) {
+    a->words[tile / 64] |= (uint64_t) 1 << (tile % 64);
+}
+
+#endif // BITBOARD_H
@@ -0,0 +1,239 @@
+// pthread and errno values like EINVAL need POSIX.
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+
+// A cache file is a header of four little endian 32-bit integers,
+// the magic, the version, BOARD_SIZE and the record size,
+// followed by a record per entry: its puzzle, whether it's solved,
+// and its values.
+#define CACHE_FILE_VERSION (1)
+#define CACHE_HEADER_SIZE (16)
+#define CACHE_RECORD_SIZE (BOARD_SIZE * 2 + 1)
+
+static const uint8_t magic[4] = { 'S', 'W', 'F', 'C' };
+
+bool init_cache(SolveCache *cache, size_t capacity) {
+    *cache = (SolveCache) { 0 };
+    if (capacity < 1 || capacity >= UINT32_MAX / 2) return false;
+
+    cache->slot_count = 1;
+    while (cache->slot_count < capacity * 2) cache->slot_count *= 2;
+
+    cache->entries = malloc(capacity * sizeof(CacheEntry));
+    cache->slots = calloc(cache->slot_count, sizeof(uint32_t));
+    if (!cache->entries || !cache->slots || pthread_mutex_init(&cache->lock, NULL) != 0) {
+        free(cache->entries);
+        free(cache->slots);
+        *cache = (SolveCache) { 0 };
+        return false;
+    }
+
+    cache->capacity = capacity;
+    return true;
+}
+
+void free_cache(SolveCache *cache) {
+    pthread_mutex_destroy(&cache->lock);
+    free(cache->entries);
+    free(cache->slots);
+    *cache = (SolveCache) { 0 };
+}
+
+// Find the slot of a puzzle, or the empty slot it would go in.
+static size_t find_slot(const SolveCache *cache, uint64_t hash, const uint8_t puzzle[BOARD_SIZE]) {
+    size_t mask = cache->slot_count - 1;
+    size_t slot = hash & mask;
+    while (cache->slots[slot]) {
+        const CacheEntry *entry = &cache->entries[cache->slots[slot] - 1];
+        if (entry->hash == hash && memcmp(entry->puzzle, puzzle, BOARD_SIZE) == 0) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// Empty a slot, moving the entries after it back into the hole
+// if that gets them closer to where their hash starts them.
+static void remove_slot(SolveCache *cache, size_t hole) {
+    size_t mask = cache->slot_count - 1;
+    for (size_t slot = (hole + 1) & mask; cache->slots[slot]; slot = (slot + 1) & mask) {
+        size_t home = cache->entries[cache->slots[slot] - 1].hash & mask;
+        if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+            cache->slots[hole] = cache->slots[slot];
+            hole = slot;
+        }
+    }
+    cache->slots[hole] = 0;
+}
+
+// Get an entry that isn't in use, evicting one if the cache is full.
+static CacheEntry *get_free_entry(SolveCache *cache) {
+    if (cache->count < cache->capacity) return &cache->entries[cache->count++];
+
+    while (cache->entries[cache->hand].referenced) {
+        cache->entries[cache->hand].referenced = false;
+        cache->hand = (cache->hand + 1) % cache->capacity;
+    }
+
+    CacheEntry *entry = &cache->entries[cache->hand];
+    cache->hand = (cache->hand + 1) % cache->capacity;
+    remove_slot(cache, find_slot(cache, entry->hash, entry->puzzle));
+    return entry;
+}
+
+// Has to be called with the lock held.
+static const CacheEntry *find_entry(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE]) {
+    uint32_t index = cache->slots[find_slot(cache, hash_values(puzzle), puzzle)];
+    if (!index) return NULL;
+
+    CacheEntry *entry = &cache->entries[index - 1];
+    entry->referenced = true;
+    return entry;
+}
+
+// Has to be called with the lock held.
+static void add_entry(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE], const uint8_t values[BOARD_SIZE], bool solved) {
+    uint64_t hash = hash_values(puzzle);
+    size_t slot = find_slot(cache, hash, puzzle);
+
+    // Another worker may have added the same puzzle in the meantime.
+    CacheEntry *entry;
+    if (cache->slots[slot]) {
+        entry = &cache->entries[cache->slots[slot] - 1];
+    } else {
+        entry = get_free_entry(cache);
+        entry->hash = hash;
+        memcpy(entry->puzzle, puzzle, BOARD_SIZE);
+        entry->referenced = false;
+
+        // Evicting may have moved the slots around.
+        slot = find_slot(cache, hash, puzzle);
+        cache->slots[slot] = (uint32_t) (entry - cache->entries) + 1;
+    }
+
+    // Whatever an unsolved puzzle's values were, they're never read,
+    // so they're stored as empty instead (which is also what's saved).
+    if (solved) {
+        memcpy(entry->values, values, BOARD_SIZE);
+    } else {
+        memset(entry->values, EMPTY_TILE, BOARD_SIZE);
+    }
+    entry->solved = solved;
+}
+
+bool find_solution(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE], Solution *solution, CacheLookup *lookup) {
+    pthread_mutex_lock(&cache->lock);
+    const CacheEntry *entry = find_entry(cache, puzzle);
+    if (entry) {
+        memcpy(solution->values, entry->values, BOARD_SIZE);
+        solution->solved = entry->solved;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (entry) return true;
+
+    get_canonical_form(puzzle, lookup->canonical, &lookup->transform);
+
+    uint8_t values[BOARD_SIZE];
+    pthread_mutex_lock(&cache->lock);
+    entry = find_entry(cache, lookup->canonical);
+    if (entry) {
+        memcpy(values, entry->values, BOARD_SIZE);
+        solution->solved = entry->solved;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    if (!entry) return false;
+
+    if (solution->solved) {
+        undo_transform(&lookup->transform, values, solution->values);
+    } else {
+        memcpy(solution->values, values, BOARD_SIZE);
+    }
+
+    // Save the next repeat of the puzzle from finding the canonical form.
+    pthread_mutex_lock(&cache->lock);
+    add_entry(cache, puzzle, solution->values, solution->solved);
+    pthread_mutex_unlock(&cache->lock);
+    return true;
+}
+
+void add_solution(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE], const CacheLookup *lookup, const Solution *solution) {
+    uint8_t values[BOARD_SIZE];
+    memcpy(values, solution->values, BOARD_SIZE);
+    if (solution->solved) apply_transform(&lookup->transform, solution->values, values);
+
+    pthread_mutex_lock(&cache->lock);
+    add_entry(cache, lookup->canonical, values, solution->solved);
+    add_entry(cache, puzzle, solution->values, solution->solved);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+static void write_header(uint8_t header[CACHE_HEADER_SIZE]) {
+    const uint32_t fields[4] = { 0, CACHE_FILE_VERSION, BOARD_SIZE, CACHE_RECORD_SIZE };
+    for (int field = 1; field < 4; ++field) {
+        for (int i = 0; i < 4; ++i) header[field * 4 + i] = (uint8_t) (fields[field] >> (i * 8));
+    }
+    memcpy(header, magic, sizeof(magic));
+}
+
+// Every value has to be one a transform can relabel.
+static bool is_valid_record(const uint8_t record[CACHE_RECORD_SIZE]) {
+    bool solved = record[BOARD_SIZE];
+    if (record[BOARD_SIZE] > 1) return false;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (record[i] >= TILE_STATES && record[i] != EMPTY_TILE) return false;
+        if (solved && record[BOARD_SIZE + 1 + i] >= TILE_STATES) return false;
+    }
+    return true;
+}
+
+bool load_cache(SolveCache *cache, const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (!in) return false;
+
+    uint8_t header[CACHE_HEADER_SIZE], expected[CACHE_HEADER_SIZE];
+    write_header(expected);
+    if (fread(header, 1, sizeof(header), in) != sizeof(header) || memcmp(header, expected, sizeof(header)) != 0) {
+        fclose(in);
+        errno = EINVAL;
+        return false;
+    }
+
+    // If the file has more entries than fit, the ones after evict the ones before.
+    uint8_t record[CACHE_RECORD_SIZE];
+    bool valid = true;
+    pthread_mutex_lock(&cache->lock);
+    while (valid && fread(record, 1, sizeof(record), in) == sizeof(record)) {
+        valid = is_valid_record(record);
+        if (valid) add_entry(cache, record, record + BOARD_SIZE + 1, record[BOARD_SIZE]);
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    bool read = valid && !ferror(in);
+    if (!valid) errno = EINVAL;
+    fclose(in);
+    return read;
+}
+
+bool save_cache(SolveCache *cache, const char *path) {
+    FILE *out = fopen(path, "wb");
+    if (!out) return false;
+
+    uint8_t header[CACHE_HEADER_SIZE];
+    write_header(header);
+    bool written = fwrite(header, 1, sizeof(header), out) == sizeof(header);
+
+    pthread_mutex_lock(&cache->lock);
+    for (size_t i = 0; written && i < cache->count; ++i) {
+        const CacheEntry *entry = &cache->entries[i];
+        written = fwrite(entry->puzzle, 1, BOARD_SIZE, out) == BOARD_SIZE
+            && fputc(entry->solved, out) != EOF
+            && fwrite(entry->values, 1, BOARD_SIZE, out) == BOARD_SIZE;
+    }
+    pthread_mutex_unlock(&cache->lock);
+
+    return fclose(out) == 0 && written;
+}
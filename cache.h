@@ -0,0 +1,77 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include "generator.h"
+#include "symmetry.h"
+
+// A bounded map from puzzles to their solutions, shared by the workers
+// solving a file of puzzles (see solve_puzzles).
+//
+// A solved puzzle is added as it is, so repeats of it are found without
+// any more work, and in its canonical form (see symmetry.h), with the
+// solution moved to the canonical form's frame. A puzzle that isn't in the
+// cache as it is is looked up by its canonical form, and the solution
+// found is moved back through the transform to the puzzle's frame.
+//
+// Once the cache is full, entries are evicted with the CLOCK algorithm:
+// a hand sweeps the entries, giving every entry used since it last passed
+// another go round, and evicting the first one that wasn't used.
+typedef struct CacheEntry {
+    uint64_t hash;
+    uint8_t puzzle[BOARD_SIZE];
+    // Every value is EMPTY_TILE if the puzzle has no solution.
+    uint8_t values[BOARD_SIZE];
+    bool solved;
+    bool referenced;
+} CacheEntry;
+
+typedef struct SolveCache {
+    CacheEntry *entries;
+    size_t capacity;
+    size_t count;
+    size_t hand;
+
+    // An open addressed table of entry indices + 1 (0 for an empty slot),
+    // by the hash of their puzzles. It has a power of two slots,
+    // at least twice as many as entries.
+    uint32_t *slots;
+    size_t slot_count;
+
+    // Every lookup and insert takes the lock, finding the canonical form
+    // (which takes much longer) is done outside of it.
+    pthread_mutex_t lock;
+} SolveCache;
+
+// Returns false if there isn't enough memory for the entries.
+bool init_cache(SolveCache *cache, size_t capacity);
+void free_cache(SolveCache *cache);
+
+// The canonical form of a puzzle that wasn't in the cache,
+// so adding its solution doesn't have to find it again.
+typedef struct CacheLookup {
+    uint8_t canonical[BOARD_SIZE];
+    Transform transform;
+} CacheLookup;
+
+// Look a puzzle (see EMPTY_TILE) up, exactly first and then by its
+// canonical form. Returns false if neither is in the cache,
+// in which case the lookup is filled in for add_solution.
+bool find_solution(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE], Solution *solution, CacheLookup *lookup);
+
+// Add a puzzle that wasn't found and its solution (or that it has none),
+// both as it is and in its canonical form.
+void add_solution(SolveCache *cache, const uint8_t puzzle[BOARD_SIZE], const CacheLookup *lookup, const Solution *solution);
+
+// The cache can be kept in a file between runs: loading adds the file's
+// entries to the cache, saving writes every entry of the cache to the file.
+// The file isn't a second level behind the entries in memory: it's only
+// read at the start and written at the end, so an entry evicted in between
+// is gone from both, and the file never holds more than the capacity.
+// Both return false (with errno set) if the file can't be read or written,
+// and loading also if it isn't a cache file of this board size.
+bool load_cache(SolveCache *cache, const char *path);
+bool save_cache(SolveCache *cache, const char *path);
+
+#endif // CACHE_H
@@ -0,0 +1,226 @@
+#include <stddef.h>
+#include "bitboard.h"
+#include "dlx.h"
+
+// Link a column header for every constraint in a ring with the root,
+// and then four nodes for every value left in each tile, one in each of
+// the constraints the value covers.
+static void build_matrix(DlxSolver *dlx, const Board *board) {
+    DlxNode *nodes = dlx->nodes;
+    for (int column = 0; column <= DLX_COLUMNS; ++column) {
+        nodes[column] = (DlxNode) {
+            .left = column ? column - 1 : DLX_COLUMNS,
+            .right = column < DLX_COLUMNS ? column + 1 : 0,
+            .up = column,
+            .down = column,
+            .column = column,
+            .row = -1,
+        };
+        dlx->column_sizes[column] = 0;
+    }
+
+    int next = DLX_COLUMNS + 1;
+    for (int tile = 0; tile < BOARD_SIZE; ++tile) {
+        int x = tile % BOARD_WIDTH;
+        int y = tile / BOARD_WIDTH;
+        int box = (y / BOX_WIDTH) * BOX_WIDTH + x / BOX_WIDTH;
+
+        for (unsigned int values = board->tiles[tile]; values; values &= values - 1) {
+            int value = lowest_bit(values);
+            const int columns[4] = {
+                1 + tile,
+                1 + BOARD_SIZE + y * TILE_STATES + value,
+                1 + BOARD_SIZE * 2 + x * TILE_STATES + value,
+                1 + BOARD_SIZE * 3 + box * TILE_STATES + value,
+            };
+
+            for (int k = 0; k < 4; ++k) {
+                int node = next + k;
+                int column = columns[k];
+                nodes[node] = (DlxNode) {
+                    .left = next + (k + 3) % 4,
+                    .right = next + (k + 1) % 4,
+                    .up = nodes[column].up,
+                    .down = column,
+                    .column = column,
+                    .row = tile * TILE_STATES + value,
+                };
+                nodes[nodes[column].up].down = node;
+                nodes[column].up = node;
+                ++dlx->column_sizes[column];
+            }
+            next += 4;
+        }
+    }
+}
+
+// Take a column out of the ring, along with every row that covers it
+// from the other columns those rows are in.
+static void cover_column(DlxSolver *dlx, int column) {
+    DlxNode *nodes = dlx->nodes;
+    nodes[nodes[column].left].right = nodes[column].right;
+    nodes[nodes[column].right].left = nodes[column].left;
+
+    for (int row = nodes[column].down; row != column; row = nodes[row].down) {
+        for (int node = nodes[row].right; node != row; node = nodes[node].right) {
+            nodes[nodes[node].up].down = nodes[node].down;
+            nodes[nodes[node].down].up = nodes[node].up;
+            --dlx->column_sizes[nodes[node].column];
+        }
+    }
+}
+
+// Undo cover_column, in exactly the reverse order.
+static void uncover_column(DlxSolver *dlx, int column) {
+    DlxNode *nodes = dlx->nodes;
+    for (int row = nodes[column].up; row != column; row = nodes[row].up) {
+        for (int node = nodes[row].left; node != row; node = nodes[node].left) {
+            ++dlx->column_sizes[nodes[node].column];
+            nodes[nodes[node].up].down = node;
+            nodes[nodes[node].down].up = node;
+        }
+    }
+
+    nodes[nodes[column].left].right = column;
+    nodes[nodes[column].right].left = column;
+}
+
+// Choosing a row covers the rest of the columns it's in.
+static void select_row(DlxSolver *dlx, int row) {
+    for (int node = dlx->nodes[row].right; node != row; node = dlx->nodes[node].right) {
+        cover_column(dlx, dlx->nodes[node].column);
+    }
+}
+
+static void unselect_row(DlxSolver *dlx, int row) {
+    for (int node = dlx->nodes[row].left; node != row; node = dlx->nodes[node].left) {
+        uncover_column(dlx, dlx->nodes[node].column);
+    }
+}
+
+// The column with the fewest rows left, stopping early at one with
+// none (a dead end) or one (a forced value).
+static int choose_column(const DlxSolver *dlx) {
+    int best = dlx->nodes[0].right;
+    for (int column = best; column != 0; column = dlx->nodes[column].right) {
+        if (dlx->column_sizes[column] < dlx->column_sizes[best]) best = column;
+        if (dlx->column_sizes[best] <= 1) break;
+    }
+    return best;
+}
+
+// Search for up to `limit` solutions, and return how many were found.
+// When the limit is reached, the frames up to depth hold the rows of the
+// last solution, and the matrix is left as it was then. With a random
+// number generator each column's rows are tried from a random one on,
+// otherwise from the first.
+static int search(DlxSolver *dlx, Random *random, int limit, int *depth) {
+    DlxNode *nodes = dlx->nodes;
+    DlxFrame *frames = dlx->frames;
+    int solutions = 0;
+    *depth = 0;
+    dlx->backtracks = 0;
+
+    while (true) {
+        if (nodes[0].right == 0) {
+            if (++solutions >= limit) return solutions;
+        } else {
+            int column = choose_column(dlx);
+            int size = dlx->column_sizes[column];
+            if (size > 0) {
+                cover_column(dlx, column);
+                int row = nodes[column].down;
+                int start = random ? get_random_value(random, 0, size - 1) : 0;
+                for (int i = 0; i < start; ++i) row = nodes[row].down;
+
+                frames[(*depth)++] = (DlxFrame) { .column = column, .node = row, .tried = 0, .size = size };
+                select_row(dlx, row);
+                continue;
+            }
+            ++dlx->backtracks;
+        }
+
+        // Move the deepest level on to its next row (going round the column,
+        // past its header), and back up past the levels that are out of them.
+        while (*depth > 0) {
+            DlxFrame *frame = &frames[*depth - 1];
+            unselect_row(dlx, frame->node);
+            if (++frame->tried < frame->size) {
+                frame->node = nodes[frame->node].down;
+                if (frame->node == frame->column) frame->node = nodes[frame->node].down;
+                select_row(dlx, frame->node);
+                break;
+            }
+            uncover_column(dlx, frame->column);
+            --*depth;
+        }
+        if (*depth == 0) return solutions;
+    }
+}
+
+bool dlx_solve_board(DlxSolver *dlx, Board *board, Random *random) {
+    build_matrix(dlx, board);
+    int depth;
+    bool solved = search(dlx, random, 1, &depth) == 1;
+
+    board->backtracks = dlx->backtracks;
+    for (int pass = 0; pass < PASS_COUNT; ++pass) board->pass_changes[pass] = 0;
+    if (!solved) return false;
+
+    // Every row chosen is a value of a tile, and collapsing them can't
+    // contradict, since they're a solution.
+    for (int level = 0; level < depth; ++level) {
+        int row = dlx->nodes[dlx->frames[level].node].row;
+        int tile = row / TILE_STATES;
+        int x = tile % BOARD_WIDTH;
+        int y = tile / BOARD_WIDTH;
+        if (!is_collapsed(board, x, y)) collapse_tile(board, x, y, row % TILE_STATES);
+    }
+    return true;
+}
+
+int dlx_count_solutions(DlxSolver *dlx, Board *board, int limit) {
+    build_matrix(dlx, board);
+    int depth;
+    return search(dlx, NULL, limit, &depth);
+}
+
+static bool solve_wfc(DlxSolver *dlx, Board *board, Random *random) {
+    (void) dlx;
+    return solve_board(board, random);
+}
+
+static int count_wfc(DlxSolver *dlx, Board *board, int limit) {
+    (void) dlx;
+    return count_solutions(board, limit);
+}
+
+// ENGINE_AUTO has no functions of its own, it's always resolved first.
+static const struct {
+    const char *name;
+    bool (*solve)(DlxSolver *dlx, Board *board, Random *random);
+    int (*count)(DlxSolver *dlx, Board *board, int limit);
+} engine_table[ENGINE_COUNT] = {
+    { "wfc", solve_wfc, count_wfc },
+    { "dlx", dlx_solve_board, dlx_count_solutions },
+    { "auto", NULL, NULL },
+};
+
+int resolve_engine(int engine, const Board *board) {
+    if (engine != ENGINE_AUTO) return engine;
+    if (board->passes & PASS_HIDDEN_SINGLES) return ENGINE_WFC;
+    int collapsed = bitboard_count(&board->collapsed_tiles);
+    return collapsed >= AUTO_DLX_MIN && collapsed < AUTO_DLX_MAX ? ENGINE_DLX : ENGINE_WFC;
+}
+
+const char *get_engine_name(int engine) {
+    return engine_table[engine].name;
+}
+
+bool solve_with_engine(int engine, DlxSolver *dlx, Board *board, Random *random) {
+    return engine_table[resolve_engine(engine, board)].solve(dlx, board, random);
+}
+
+int count_with_engine(int engine, DlxSolver *dlx, Board *board, int limit) {
+    return engine_table[resolve_engine(engine, board)].count(dlx, board, limit);
+}
@@ -0,0 +1,113 @@
+#ifndef DLX_H
+#define DLX_H
+
+#include "wfc.h"
+
+// Another engine for the board: Sudoku as an exact cover problem,
+// solved with Knuth's Algorithm X on dancing links (DLX).
+//
+// Every value a tile can still take is a row, which covers four columns:
+// the tile, and the value in the tile's row, column and box. A solution is
+// a set of rows that covers every column exactly once. Each step covers the
+// column with the fewest rows left, which both picks the tile with the
+// fewest values and finds hidden singles, with nothing to propagate:
+// covering a column unlinks every row that clashes with it in O(1) each,
+// and uncovering links them back in, in reverse.
+// That does much less per step than the board, which pays off when the
+// search is most of the work, like counting the solutions of a sparse puzzle.
+//
+// The rows are only the values left in the board's tiles, so the passes
+// that have already run on it (and the givens) shrink the matrix.
+
+#define DLX_COLUMNS (BOARD_SIZE * 4)
+#define DLX_ROWS (BOARD_SIZE * TILE_STATES)
+
+// A header for the root and every column, and four nodes for every row.
+#define DLX_NODES (1 + DLX_COLUMNS + DLX_ROWS * 4)
+
+// A node of the matrix, linked to its neighbours in both directions.
+// Column headers are their own column, and have the row -1.
+typedef struct DlxNode {
+    int left;
+    int right;
+    int up;
+    int down;
+    int column;
+    int row;
+} DlxNode;
+
+// The search is kept on an explicit stack, like solve_board's.
+// Each level is covering a column, trying its rows from a random one on.
+typedef struct DlxFrame {
+    int column;
+    int node;
+    int tried;
+    int size;
+} DlxFrame;
+
+// Everything the solver works with is sized up front, so nothing is
+// allocated while it searches. Node 0 is the root, and nodes 1 to
+// DLX_COLUMNS are the column headers. It's big (over a megabyte for
+// 25x25 boards), so it's best kept off the stack.
+typedef struct DlxSolver {
+    DlxNode nodes[DLX_NODES];
+    int column_sizes[DLX_COLUMNS + 1];
+    DlxFrame frames[BOARD_SIZE];
+
+    // The number of rows tried that ran into a column without any rows,
+    // to compare with the board's backtracks.
+    long backtracks;
+} DlxSolver;
+
+// Solve a board the same way solve_board does, collapsing every tile
+// of it to the solution found (so the board can be undone as usual).
+// Returns false (leaving the board as it was) if it has no solution.
+// The random number generator picks the row each column starts from.
+bool dlx_solve_board(DlxSolver *dlx, Board *board, Random *random);
+
+// Count a board's solutions, stopping at `limit` like count_solutions.
+// The board isn't changed.
+int dlx_count_solutions(DlxSolver *dlx, Board *board, int limit);
+
+// The engines that can solve a board (and count its solutions):
+// the board's own search (solve_board and count_solutions), DLX, or
+// ENGINE_AUTO, which picks one of them for each board (see resolve_engine).
+// The DLX solver is only used by ENGINE_DLX and ENGINE_AUTO,
+// and can be NULL otherwise.
+#define ENGINE_WFC (0)
+#define ENGINE_DLX (1)
+#define ENGINE_AUTO (2)
+#define ENGINE_COUNT (3)
+
+// ENGINE_AUTO solves a board with DLX when at least AUTO_DLX_MIN and fewer
+// than AUTO_DLX_MAX of its tiles are collapsed, and with WFC otherwise,
+// or always with WFC when the board collapses hidden singles, which takes
+// away most of what DLX saves (and then it's faster on every puzzle).
+// An empty or nearly empty board has so many solutions that the board's
+// search hardly ever backtracks, and a nearly full one is mostly solved by
+// propagating, but in between (where the hard puzzles are) it can backtrack
+// for a long time, while DLX is never more than about twice as slow.
+// Both engines take about as long from an eighth to a sixth collapsed,
+// but the range where DLX is faster is wider the bigger the board is:
+// the board's search is slower up to about a third collapsed on 9x9
+// boards, and up to over half on 16x16 ones.
+#ifndef AUTO_DLX_MIN
+#define AUTO_DLX_MIN (BOARD_SIZE / 8)
+#endif
+#ifndef AUTO_DLX_MAX
+#if BOARD_ORDER >= 4
+#define AUTO_DLX_MAX (BOARD_SIZE * 3 / 5)
+#else
+#define AUTO_DLX_MAX (BOARD_SIZE / 3)
+#endif
+#endif
+
+// The engine that solves the board: the engine itself,
+// or for ENGINE_AUTO the one it picks for the board as it is now.
+int resolve_engine(int engine, const Board *board);
+
+const char *get_engine_name(int engine);
+bool solve_with_engine(int engine, DlxSolver *dlx, Board *board, Random *random);
+int count_with_engine(int engine, DlxSolver *dlx, Board *board, int limit);
+
+#endif // DLX_H
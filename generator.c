@@ -0,0 +1,205 @@
+// sched_yield and sysconf are POSIX, not C99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "batch.h"
+#include "generator.h"
+#include "puzzles.h"
+#include "queue.h"
+#include "symmetry.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct Worker {
+    SolutionQueue queue;
+    Random random;
+    Board board;
+    Batch batch;
+    int engine;
+    DlxSolver dlx;
+    pthread_t thread;
+
+    // The number of boards this worker has to generate.
+    long count;
+    bool dig;
+    bool dedup;
+    GeneratorStats stats;
+} Worker;
+
+int get_core_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    int cores = (int) info.dwNumberOfProcessors;
+#else
+    int cores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return cores > 0 ? cores : 1;
+}
+
+void get_solution(Board *board, Solution *solution) {
+    solution->solved = true;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        int x = i % BOARD_WIDTH;
+        int y = i / BOARD_WIDTH;
+        solution->values[i] = (uint8_t) get_collapsed_value(board, x, y);
+    }
+}
+
+void add_board_stats(GeneratorStats *stats, const Board *board) {
+    stats->backtracks += board->backtracks;
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+        stats->pass_changes[pass] += board->pass_changes[pass];
+    }
+}
+
+void add_stats(GeneratorStats *stats, const GeneratorStats *other) {
+    stats->backtracks += other->backtracks;
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+        stats->pass_changes[pass] += other->pass_changes[pass];
+    }
+    stats->givens += other->givens;
+    stats->cache_hits += other->cache_hits;
+    stats->races += other->races;
+    add_solver_stats(&stats->solver, &other->solver);
+}
+
+// Hand a solved board over to the consumer, digging a puzzle out of it first
+// if the worker is meant to.
+static void push_board(Worker *worker, Solution *solution) {
+    if (worker->dig) {
+        // The board is free to be worked on, its values are in the solution.
+        worker->stats.givens += dig_puzzle(&worker->board, worker->engine, &worker->dlx, &worker->random, solution);
+    }
+
+    // The consumer only has to look the hash up, which keeps
+    // the expensive part on the workers.
+    if (worker->dedup) {
+        uint8_t canonical[BOARD_SIZE];
+        get_canonical_form(solution->values, canonical, NULL);
+        solution->hash = hash_values(canonical);
+    }
+    push_solution(&worker->queue);
+}
+
+static void *run_worker(void *data) {
+    Worker *worker = data;
+
+    for (long i = 0; i < worker->count; ++i) {
+        // An empty board always has a solution.
+        reset_tiles(&worker->board);
+        solve_with_engine(worker->engine, &worker->dlx, &worker->board, &worker->random);
+        add_board_stats(&worker->stats, &worker->board);
+
+        Solution *solution = reserve_solution(&worker->queue);
+        get_solution(&worker->board, solution);
+        push_board(worker, solution);
+    }
+
+#if SOLVER_STATS
+    // Digging works on the board too, so this covers it as well.
+    worker->stats.solver = worker->board.stats;
+#endif
+    return NULL;
+}
+
+// Generate the boards BATCH_SIZE at a time, taking them in the order
+// they're solved in. Restarted boards are counted as backtracks.
+static void *run_batch_worker(void *data) {
+    Worker *worker = data;
+    reset_batch(&worker->batch, &worker->random);
+
+    long generated = 0;
+    while (generated < worker->count) {
+        uint32_t solved = step_batch(&worker->batch);
+        for (int board = 0; board < BATCH_SIZE && generated < worker->count; ++board) {
+            if (!(solved & (1u << board))) continue;
+
+            Solution *solution = reserve_solution(&worker->queue);
+            solution->solved = true;
+            get_batch_values(&worker->batch, board, solution->values);
+            push_board(worker, solution);
+            ++generated;
+        }
+    }
+
+    worker->stats.backtracks = worker->batch.restarts;
+    return NULL;
+}
+
+bool generate_boards(
+    const GeneratorOptions *options,
+    SolutionCallback callback, void *user_data, GeneratorStats *stats
+) {
+    long count = options->count;
+    int threads = options->threads;
+    if (threads < 1) threads = 1;
+    if (threads > count) threads = count > 0 ? (int) count : 1;
+
+    Worker *workers = calloc((size_t) threads, sizeof(Worker));
+    if (!workers) return false;
+
+    // Board i is generated by worker i % threads,
+    // so the first few workers pick up the remainder.
+    int started = 0;
+    for (; started < threads; ++started) {
+        Worker *worker = &workers[started];
+        worker->count = count / threads + (started < count % threads);
+        worker->dig = options->dig;
+        worker->dedup = options->dedup;
+        worker->board.passes = options->passes;
+        worker->board.selection = options->selection;
+        worker->board.ordering = options->ordering;
+        worker->engine = options->engine;
+        seed_random(&worker->random, options->seed, (uint64_t) started);
+
+        void *(*run)(void *) = options->batched ? run_batch_worker : run_worker;
+        if (pthread_create(&worker->thread, NULL, run, worker) != 0) break;
+    }
+
+    // Drain the queues in the order the boards were assigned,
+    // which keeps the output reproducible regardless of timing.
+    // Only the hashes of the boards are kept to find the duplicates,
+    // so two different boards could be taken as the same one,
+    // but with 64-bit hashes that takes billions of boards.
+    HashSet seen = { 0 };
+    bool tracked = true;
+    long duplicates = 0;
+
+    long written = 0;
+    if (started == threads) {
+        for (; written < count; ++written) {
+            SolutionQueue *queue = &workers[written % threads].queue;
+            const Solution *solution = peek_solution(queue);
+
+            bool added = true;
+            if (options->dedup && tracked) tracked = add_hash(&seen, solution->hash, &added);
+            if (added) callback(solution, user_data);
+            else ++duplicates;
+            pop_solution(queue);
+        }
+    }
+    free_hash_set(&seen);
+
+    *stats = (GeneratorStats) { 0 };
+    stats->duplicates = duplicates;
+    for (int i = 0; i < started; ++i) {
+        // If a thread failed to start, let the others finish
+        // by consuming whatever they still produce.
+        while (started != threads && workers[i].queue.tail < (size_t) workers[i].count) {
+            peek_solution(&workers[i].queue);
+            pop_solution(&workers[i].queue);
+        }
+
+        pthread_join(workers[i].thread, NULL);
+        add_stats(stats, &workers[i].stats);
+    }
+
+    free(workers);
+    return written == count && tracked;
+}
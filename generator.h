@@ -0,0 +1,116 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <stdint.h>
+#include "dlx.h"
+#include "wfc.h"
+
+struct SolveCache;
+
+// A finished board, stored as the collapsed value (0-8) of every tile.
+// Generated boards are always solved, puzzles may not have a solution,
+// in which case the values are left undefined.
+// Puzzles (see dig_puzzle) are stored the same way,
+// with EMPTY_TILE as the value of every tile that isn't given.
+#define EMPTY_TILE (0xFF)
+typedef struct Solution {
+    uint8_t values[BOARD_SIZE];
+    bool solved;
+
+    // The hash of the values' canonical form (see symmetry.h),
+    // only set when the generator drops duplicates.
+    uint64_t hash;
+} Solution;
+
+// Receives every generated (or solved) board, in order, on the thread
+// that called generate_boards (or solve_puzzles).
+typedef void (*SolutionCallback)(const Solution *solution, void *user_data);
+
+// Get the number of cores available to this process.
+int get_core_count(void);
+
+typedef struct GeneratorOptions {
+    // The number of boards to generate, and the worker threads to use.
+    long count;
+    int threads;
+
+    // Worker i draws its random numbers from stream i of the seed,
+    // so the same seed and thread count always produce the same boards.
+    uint64_t seed;
+
+    // Solve a batch of boards at a time in lockstep (see batch.h)
+    // instead of one board at a time with solve_board.
+    bool batched;
+
+    // Dig a puzzle with a unique solution out of every board
+    // (see dig_puzzle), and pass those on instead.
+    bool dig;
+
+    // Drop every board (or puzzle) that's equivalent to one that was passed
+    // on before it, under the symmetries of the board (see symmetry.h).
+    // Fewer than count boards are passed on if any are dropped.
+    bool dedup;
+
+    // The PASS_ flags and the SELECT_ and ORDER_ heuristics every worker's
+    // board uses. Batches always collapse hidden singles, don't use any
+    // other passes, and always take the tile with the least entropy.
+    unsigned int passes;
+    int selection;
+    int ordering;
+
+    // The ENGINE_ that solves the boards (and counts the solutions when
+    // digging puzzles). DLX doesn't use the passes or the heuristics,
+    // and batches always solve with their own. With ENGINE_AUTO every
+    // board (and every count) gets the engine picked for it.
+    int engine;
+
+    // When solving puzzles, race every puzzle that isn't solved within
+    // this many steps (see continue_solve) on threads racers instead
+    // (see portfolio.h), with the puzzles solved one at a time.
+    // 0 never races, and solves the puzzles on threads workers.
+    // Only the puzzles solved with the WFC engine can be raced.
+    long race_steps;
+
+    // The cache solve_puzzles looks the puzzles up in (see cache.h), if any.
+    struct SolveCache *cache;
+} GeneratorOptions;
+
+// What the workers did to generate the boards, added up.
+typedef struct GeneratorStats {
+    // The number of times the solver had to backtrack
+    // (or restart a board, when batched).
+    long backtracks;
+    long pass_changes[PASS_COUNT];
+
+    // The number of givens left in the puzzles, when digging,
+    // and the number of boards dropped as duplicates.
+    long givens;
+    long duplicates;
+
+    // The number of puzzles found in the cache, when solving with one.
+    long cache_hits;
+
+    // The number of puzzles that had to be raced (see race_steps).
+    long races;
+
+    // What the single board solver did on every worker's board,
+    // which stays empty unless built with SOLVER_STATS (and when batched).
+    SolverStats solver;
+} GeneratorStats;
+
+// Copy the values of a solved board into a solution.
+void get_solution(Board *board, Solution *solution);
+
+// Add what solving a board took (or another set of stats) to the stats.
+void add_board_stats(GeneratorStats *stats, const Board *board);
+void add_stats(GeneratorStats *stats, const GeneratorStats *other);
+
+// Generate boards on worker threads, passing them to the callback in order.
+// Returns false if the workers could not be started,
+// or there wasn't enough memory to keep track of the duplicates.
+bool generate_boards(
+    const GeneratorOptions *options,
+    SolutionCallback callback, void *user_data, GeneratorStats *stats
+);
+
+#endif // GENERATOR_H
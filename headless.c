@@ -0,0 +1,309 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cache.h"
+#include "generator.h"
+#include "packed.h"
+#include "puzzles.h"
+
+// Generates (or solves) boards without opening a window.
+// Every solved board is written as one line of BOARD_SIZE digits
+// (see get_value_char),
+// a dug puzzle with zeros for its empty tiles,
+// and a puzzle without a solution as a line of zeros,
+// or as records of a packed file (see packed.h) with -f binary.
+
+#define DEFAULT_CACHE_ENTRIES (1 << 16)
+
+static void print_usage(const char *program) {
+    fprintf(stderr,
+        "Usage: %s [-n count] [-s seed] [-t threads] [-o file] [-f format] [-p passes] [-H select] [-V order] [-e engine] [-i file] [-c entries] [-C file] [-S file] [-r steps] [-d] [-u] [-b]\n"
+        "  -n count    Number of boards to generate (default 1)\n"
+        "  -s seed     Seed for the random number generators (default time)\n"
+        "  -t threads  Number of worker threads (default one per core)\n"
+        "  -o file     Write the boards to a file instead of stdout\n"
+        "  -f format   Write the boards as text (default) or binary\n"
+        "  -p passes   Comma separated propagation passes to run, or all\n"
+        "              (hidden-singles, naked-pairs, pointing-pairs)\n"
+        "  -H select   Pick the next tile by mrv (default), degree or weighted\n"
+        "  -V order    Try a tile's values in random (default) or lcv order\n"
+        "  -e engine   Solve with wfc, dlx (exact cover), or auto (default),\n"
+        "              which picks one by how many tiles are collapsed\n"
+        "  -i file     Solve the puzzles in a file, one per line, instead\n"
+        "              of generating boards\n"
+        "  -c entries  Cache up to this many solutions of puzzles, and look\n"
+        "              the puzzles up in it before solving them\n"
+        "  -C file     Keep the cache in a file between runs (with -c,\n"
+        "              or %d entries)\n"
+        "  -S file     Write the stats to a file as JSON (the solver's\n"
+        "              counters need a SOLVER_STATS=1 build)\n"
+        "  -r steps    Solve the puzzles one at a time, racing the ones not\n"
+        "              solved within this many steps on every thread\n"
+        "  -d          Dig a puzzle with a unique solution out of every board\n"
+        "  -u          Drop boards equivalent to one already written\n"
+        "  -b          Solve a batch of boards at a time on each thread (slower, see README)\n",
+        program, DEFAULT_CACHE_ENTRIES
+    );
+}
+
+// Counts the boards written, and the puzzles without a solution.
+static uint64_t written = 0;
+static long unsolved = 0;
+
+// Write a solved board as a single line of digits.
+static void write_solution(const Solution *solution, void *user_data) {
+    FILE *out = user_data;
+    char line[BOARD_SIZE + 1];
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        bool given = solution->solved && solution->values[i] != EMPTY_TILE;
+        line[i] = given ? get_value_char(solution->values[i]) : '0';
+    }
+    line[BOARD_SIZE] = '\n';
+    fwrite(line, 1, sizeof(line), out);
+
+    ++written;
+    unsolved += !solution->solved;
+}
+
+static void write_packed_solution(const Solution *solution, void *user_data) {
+    FILE *out = user_data;
+    uint8_t record[PACKED_RECORD_SIZE];
+    pack_solution(solution, record);
+    fwrite(record, 1, sizeof(record), out);
+
+    ++written;
+    unsolved += !solution->solved;
+}
+
+// Turn a comma separated list of pass names into PASS_ flags.
+// Returns false if one of the names isn't a pass.
+static bool parse_passes(const char *list, unsigned int *passes) {
+    *passes = 0;
+    if (strcmp(list, "all") == 0) {
+        *passes = PASS_ALL;
+        return true;
+    }
+
+    while (*list) {
+        size_t length = strcspn(list, ",");
+        int pass = 0;
+        for (; pass < PASS_COUNT; ++pass) {
+            const char *name = get_pass_name(pass);
+            if (strlen(name) == length && strncmp(list, name, length) == 0) break;
+        }
+        if (pass == PASS_COUNT) return false;
+
+        *passes |= 1u << pass;
+        list += length;
+        if (*list) ++list;
+    }
+    return true;
+}
+
+// Write the stats as a JSON object. The solver's counters are only there
+// in a build that has them (see SOLVER_STATS).
+static bool write_stats(const char *path, const GeneratorStats *stats) {
+    FILE *out = fopen(path, "w");
+    if (!out) return false;
+
+    fprintf(out, "{\n  \"boards\": %llu,\n", (unsigned long long) written);
+    fprintf(out, "  \"unsolved\": %ld,\n", unsolved);
+    fprintf(out, "  \"backtracks\": %ld,\n", stats->backtracks);
+    fprintf(out, "  \"givens\": %ld,\n", stats->givens);
+    fprintf(out, "  \"duplicates\": %ld,\n", stats->duplicates);
+    fprintf(out, "  \"cache_hits\": %ld,\n", stats->cache_hits);
+    fprintf(out, "  \"races\": %ld,\n", stats->races);
+    fprintf(out, "  \"pass_changes\": {");
+    for (int pass = 0; pass < PASS_COUNT; ++pass) {
+        fprintf(out, "%s\"%s\": %ld", pass ? ", " : "", get_pass_name(pass), stats->pass_changes[pass]);
+    }
+    fprintf(out, "},\n");
+
+    // Everything the solver works with is in its board, sized up front.
+    fprintf(out, "  \"capacity\": {\"board_bytes\": %zu, ", sizeof(Board));
+    fprintf(out, "\"trail_entries\": %d, \"search_frames\": %d, \"queue_entries\": %d}", TRAIL_CAPACITY, BOARD_SIZE, BOARD_SIZE);
+
+#if SOLVER_STATS
+    const SolverStats *solver = &stats->solver;
+    fprintf(out, ",\n  \"solver\": {\n");
+    fprintf(out, "    \"solves\": %ld,\n", solver->solves);
+    fprintf(out, "    \"constrains\": %ld,\n", solver->constrains);
+    fprintf(out, "    \"collapses\": %ld,\n", solver->collapses);
+    fprintf(out, "    \"removals\": %ld,\n", solver->removals);
+    fprintf(out, "    \"propagations\": %ld,\n", solver->propagations);
+    fprintf(out, "    \"backtracks\": %ld,\n", solver->backtracks);
+    fprintf(out, "    \"restarts\": %ld,\n", solver->restarts);
+    fprintf(out, "    \"peak_trail_size\": %d,\n", solver->peak_trail_size);
+    fprintf(out, "    \"peak_depth\": %d,\n", solver->peak_depth);
+    fprintf(out, "    \"select_ns\": %llu,\n", (unsigned long long) solver->select_time);
+    fprintf(out, "    \"propagate_ns\": %llu,\n", (unsigned long long) solver->propagate_time);
+    fprintf(out, "    \"cascade_depths\": [");
+    for (int depth = 0; depth < CASCADE_DEPTHS; ++depth) {
+        fprintf(out, "%s%ld", depth ? ", " : "", solver->cascade_depths[depth]);
+    }
+    fprintf(out, "]\n  }");
+#endif
+
+    fprintf(out, "\n}\n");
+    bool failed = ferror(out);
+    return fclose(out) == 0 && !failed;
+}
+
+// Find a heuristic (or engine) by its name. Returns false if none of them have it.
+static bool parse_heuristic(const char *name, const char *(*get_name)(int), int count, int *heuristic) {
+    for (*heuristic = 0; *heuristic < count; ++*heuristic) {
+        if (strcmp(name, get_name(*heuristic)) == 0) return true;
+    }
+    return false;
+}
+
+// Returns false if the format is neither text nor binary.
+static bool parse_format(const char *format, bool *binary) {
+    *binary = strcmp(format, "binary") == 0;
+    return *binary || strcmp(format, "text") == 0;
+}
+
+int main(int argc, char **argv) {
+    GeneratorOptions options = {
+        .count = 1,
+        .threads = get_core_count(),
+        .seed = (uint64_t) time(0),
+        .engine = ENGINE_AUTO,
+    };
+    const char *out_path = NULL;
+    const char *in_path = NULL;
+    const char *cache_path = NULL;
+    const char *stats_path = NULL;
+    long cache_entries = 0;
+    bool binary = false;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0) {
+            options.batched = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-d") == 0) {
+            options.dig = true;
+            continue;
+        }
+        if (strcmp(argv[i], "-u") == 0) {
+            options.dedup = true;
+            continue;
+        }
+
+        // Every other option takes a value.
+        if (i + 1 >= argc) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (strcmp(argv[i], "-n") == 0) options.count = strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-s") == 0) options.seed = strtoull(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-t") == 0) options.threads = (int) strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-o") == 0) out_path = argv[++i];
+        else if (strcmp(argv[i], "-i") == 0) in_path = argv[++i];
+        else if (strcmp(argv[i], "-c") == 0) cache_entries = strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-C") == 0) cache_path = argv[++i];
+        else if (strcmp(argv[i], "-S") == 0) stats_path = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0) options.race_steps = strtol(argv[++i], NULL, 10);
+        else if (strcmp(argv[i], "-f") == 0 && parse_format(argv[i + 1], &binary)) ++i;
+        else if (strcmp(argv[i], "-p") == 0 && parse_passes(argv[i + 1], &options.passes)) ++i;
+        else if (strcmp(argv[i], "-H") == 0 && parse_heuristic(argv[i + 1], get_selection_name, SELECTION_COUNT, &options.selection)) ++i;
+        else if (strcmp(argv[i], "-V") == 0 && parse_heuristic(argv[i + 1], get_ordering_name, ORDERING_COUNT, &options.ordering)) ++i;
+        else if (strcmp(argv[i], "-e") == 0 && parse_heuristic(argv[i + 1], get_engine_name, ENGINE_COUNT, &options.engine)) ++i;
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Packed records only hold solved boards.
+    if (binary && options.dig) {
+        fprintf(stderr, "Puzzles can't be written as binary\n");
+        return 1;
+    }
+
+    PuzzleFile puzzles;
+    if (in_path && !open_puzzles(&puzzles, in_path)) {
+        perror(in_path);
+        return 1;
+    }
+
+    // Starting without a cache file is fine, it's written at the end.
+    SolveCache cache;
+    if (cache_path && !cache_entries) cache_entries = DEFAULT_CACHE_ENTRIES;
+    if (in_path && cache_entries) {
+        if (!init_cache(&cache, (size_t) cache_entries)) {
+            fprintf(stderr, "Failed to make a cache of %ld entries\n", cache_entries);
+            return 1;
+        }
+        if (cache_path && !load_cache(&cache, cache_path) && errno != ENOENT) {
+            perror(cache_path);
+            return 1;
+        }
+        options.cache = &cache;
+    }
+
+    FILE *out = stdout;
+    if (out_path) {
+        out = fopen(out_path, "wb");
+        if (!out) {
+            perror(out_path);
+            return 1;
+        }
+    }
+
+    // The number of boards is filled in once they've all been written.
+    uint8_t header[PACKED_HEADER_SIZE];
+    if (binary) {
+        write_packed_header(header, PACKED_UNKNOWN_COUNT);
+        fwrite(header, 1, sizeof(header), out);
+    }
+
+    GeneratorStats stats;
+    SolutionCallback write = binary ? write_packed_solution : write_solution;
+    bool generated = in_path
+        ? solve_puzzles(&puzzles, &options, write, out, &stats)
+        : generate_boards(&options, write, out, &stats);
+
+    // Stdout may be a pipe, in which case the count stays unknown.
+    if (binary && fseek(out, 0, SEEK_SET) == 0) {
+        write_packed_header(header, written);
+        fwrite(header, 1, sizeof(header), out);
+    }
+    if (!generated) {
+        fprintf(stderr, "Failed to start the worker threads (or track the duplicates)\n");
+    } else {
+        fprintf(stderr, "%ld backtracks\n", stats.backtracks);
+        if (in_path) fprintf(stderr, "%ld puzzles without a solution\n", unsolved);
+        if (options.dig && !in_path && written) {
+            fprintf(stderr, "%.2f givens per puzzle\n", stats.givens / (double) written);
+        }
+        if (options.dedup && !in_path) fprintf(stderr, "%ld duplicates dropped\n", stats.duplicates);
+        if (options.cache) fprintf(stderr, "%ld cache hits\n", stats.cache_hits);
+        if (in_path && options.race_steps) fprintf(stderr, "%ld puzzles raced\n", stats.races);
+        for (int pass = 0; pass < PASS_COUNT; ++pass) {
+            if (options.passes & (1u << pass)) {
+                fprintf(stderr, "%ld %s changes\n", stats.pass_changes[pass], get_pass_name(pass));
+            }
+        }
+        if (stats_path && !write_stats(stats_path, &stats)) {
+            perror(stats_path);
+            generated = false;
+        }
+    }
+    if (out != stdout) fclose(out);
+    if (in_path) close_puzzles(&puzzles);
+
+    if (options.cache) {
+        if (cache_path && !save_cache(&cache, cache_path)) {
+            perror(cache_path);
+            generated = false;
+        }
+        free_cache(&cache);
+    }
+
+    return !generated;
+}
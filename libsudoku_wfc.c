@@ -0,0 +1,294 @@
+// pthread needs POSIX.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dlx.h"
+#include "libsudoku_wfc.h"
+#include "puzzles.h"
+
+// Fail to compile if the API's constants drift from the solver's.
+typedef char passes_check[
+    SUDOKU_PASS_HIDDEN_SINGLES == PASS_HIDDEN_SINGLES && SUDOKU_PASS_NAKED_PAIRS == PASS_NAKED_PAIRS
+    && SUDOKU_PASS_POINTING_PAIRS == PASS_POINTING_PAIRS && SUDOKU_PASS_ALL == PASS_ALL ? 1 : -1
+];
+typedef char engines_check[
+    SUDOKU_ENGINE_WFC == ENGINE_WFC && SUDOKU_ENGINE_DLX == ENGINE_DLX && SUDOKU_ENGINE_AUTO == ENGINE_AUTO
+    && SUDOKU_EMPTY == EMPTY_TILE ? 1 : -1
+];
+
+// The batch's puzzles are handed out this many at a time, which is few
+// enough to spread hard puzzles out, and many enough that the threads
+// rarely touch the shared counter.
+#define BATCH_BLOCK (64)
+
+// The seed every puzzle of a batch is solved with, on its own stream.
+#define BATCH_SEED (0)
+
+struct SudokuBoard {
+    Board board;
+    Random random;
+    int engine;
+
+    // Only allocated once the board solves with DLX (or ENGINE_AUTO).
+    DlxSolver *dlx;
+};
+
+int sudoku_api_version(void) {
+    return SUDOKU_API_VERSION;
+}
+
+int sudoku_board_width(void) {
+    return BOARD_WIDTH;
+}
+
+int sudoku_board_size(void) {
+    return BOARD_SIZE;
+}
+
+SudokuBoard *sudoku_create(uint64_t seed) {
+    SudokuBoard *board = calloc(1, sizeof(SudokuBoard));
+    if (!board) return NULL;
+
+    seed_random(&board->random, seed, 0);
+    reset_tiles(&board->board);
+    return board;
+}
+
+void sudoku_destroy(SudokuBoard *board) {
+    if (!board) return;
+    free(board->dlx);
+    free(board);
+}
+
+void sudoku_set_passes(SudokuBoard *board, unsigned int passes) {
+    board->board.passes = passes & PASS_ALL;
+}
+
+int sudoku_set_engine(SudokuBoard *board, int engine) {
+    if (engine < 0 || engine >= ENGINE_COUNT) return 0;
+    if (engine != ENGINE_WFC && !board->dlx) {
+        board->dlx = malloc(sizeof(DlxSolver));
+        if (!board->dlx) return 0;
+    }
+
+    board->engine = engine;
+    return 1;
+}
+
+void sudoku_reset(SudokuBoard *board) {
+    reset_tiles(&board->board);
+}
+
+int sudoku_set_puzzle(SudokuBoard *board, const uint8_t *puzzle) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (puzzle[i] >= TILE_STATES && puzzle[i] != EMPTY_TILE) return 0;
+    }
+    return set_puzzle(&board->board, puzzle);
+}
+
+int sudoku_collapse(SudokuBoard *board, int x, int y, int value) {
+    if (x < 0 || x >= BOARD_WIDTH || y < 0 || y >= BOARD_WIDTH || value < 0 || value >= TILE_STATES) return -1;
+
+    // collapse_tile fails the same way for a value that isn't possible,
+    // but without an undo mark to undo it with.
+    if (!is_set(&board->board, x, y, value)) return -1;
+    return collapse_tile(&board->board, x, y, value);
+}
+
+void sudoku_undo(SudokuBoard *board) {
+    undo_tiles(&board->board);
+}
+
+int sudoku_solve(SudokuBoard *board) {
+    return solve_with_engine(board->engine, board->dlx, &board->board, &board->random);
+}
+
+int sudoku_count_solutions(SudokuBoard *board, int limit) {
+    // The search only checks the limit once it finds a solution.
+    if (limit < 1) return -1;
+    return count_with_engine(board->engine, board->dlx, &board->board, limit);
+}
+
+// Write a board's values straight into a caller's buffer.
+static void write_values(Board *board, uint8_t *values) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        int x = i % BOARD_WIDTH;
+        int y = i / BOARD_WIDTH;
+        values[i] = is_collapsed(board, x, y) ? (uint8_t) get_collapsed_value(board, x, y) : EMPTY_TILE;
+    }
+}
+
+void sudoku_get_values(SudokuBoard *board, uint8_t *values) {
+    write_values(&board->board, values);
+}
+
+void sudoku_generate(SudokuBoard *board, uint8_t *values) {
+    // An empty board always has a solution.
+    reset_tiles(&board->board);
+    sudoku_solve(board);
+    write_values(&board->board, values);
+}
+
+typedef struct BatchJob {
+    const uint8_t *puzzles;
+    uint8_t *out;
+    size_t count;
+
+    // The first puzzle that hasn't been handed out yet,
+    // and the number solved by the threads helping the caller.
+    size_t next;
+    long solved;
+} BatchJob;
+
+// Solve blocks of the job's puzzles on a board until they've all been
+// handed out, and return how many of them this solved.
+static long solve_blocks(BatchJob *job, Board *board) {
+    long solved = 0;
+    board->passes = PASS_ALL;
+
+    while (true) {
+        size_t start = __atomic_fetch_add(&job->next, BATCH_BLOCK, __ATOMIC_RELAXED);
+        if (start >= job->count) return solved;
+        size_t end = start + BATCH_BLOCK < job->count ? start + BATCH_BLOCK : job->count;
+
+        for (size_t i = start; i < end; ++i) {
+            const uint8_t *puzzle = job->puzzles + i * BOARD_SIZE;
+            uint8_t *out = job->out + i * BOARD_SIZE;
+
+            Random random;
+            seed_random(&random, BATCH_SEED, (uint64_t) i);
+
+            // A value that's out of range makes the puzzle unsolvable.
+            bool valid = true;
+            for (int k = 0; k < BOARD_SIZE; ++k) valid &= puzzle[k] < TILE_STATES || puzzle[k] == EMPTY_TILE;
+
+            if (valid && set_puzzle(board, puzzle) && solve_board(board, &random)) {
+                write_values(board, out);
+                ++solved;
+            } else {
+                memset(out, EMPTY_TILE, BOARD_SIZE);
+            }
+        }
+    }
+}
+
+// The threads that help with batches, started the first time a batch needs
+// them and kept waiting for the next one after that, so a batch only pays
+// for waking them up. There's one less of them than there are cores,
+// since the caller works on its batch too.
+typedef struct BatchHelper {
+    Board board;
+    pthread_t thread;
+    int index;
+} BatchHelper;
+
+typedef struct BatchPool {
+    // Held by the caller whose batch the pool is on, for all of it,
+    // which also makes the caller's board its own.
+    pthread_mutex_t busy;
+    Board board;
+
+    // The job, and how many of the helpers take part in it: helper i does
+    // if i < wanted. Every job gets a new generation, which is what wakes
+    // the helpers up, and the caller waits for running to get back to 0.
+    pthread_mutex_t lock;
+    pthread_cond_t started;
+    pthread_cond_t finished;
+    BatchJob *job;
+    unsigned long generation;
+    int wanted;
+    int running;
+
+    BatchHelper *helpers;
+    int helper_count;
+} BatchPool;
+
+static BatchPool pool = {
+    .busy = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .started = PTHREAD_COND_INITIALIZER,
+    .finished = PTHREAD_COND_INITIALIZER,
+};
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+
+static void *run_batch_helper(void *data) {
+    BatchHelper *helper = data;
+    unsigned long generation = 0;
+
+    pthread_mutex_lock(&pool.lock);
+    while (true) {
+        while (pool.generation == generation) pthread_cond_wait(&pool.started, &pool.lock);
+        generation = pool.generation;
+        if (helper->index >= pool.wanted) continue;
+
+        BatchJob *job = pool.job;
+        pthread_mutex_unlock(&pool.lock);
+        long solved = solve_blocks(job, &helper->board);
+        __atomic_fetch_add(&job->solved, solved, __ATOMIC_RELAXED);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.running == 0) pthread_cond_signal(&pool.finished);
+    }
+    return NULL;
+}
+
+// A helper that fails to start only leaves the pool smaller.
+static void start_pool(void) {
+    int count = get_core_count() - 1;
+    pool.helpers = count > 0 ? calloc((size_t) count, sizeof(BatchHelper)) : NULL;
+    if (!pool.helpers) return;
+
+    for (; pool.helper_count < count; ++pool.helper_count) {
+        BatchHelper *helper = &pool.helpers[pool.helper_count];
+        helper->index = pool.helper_count;
+        if (pthread_create(&helper->thread, NULL, run_batch_helper, helper) != 0) break;
+        pthread_detach(helper->thread);
+    }
+}
+
+long sudoku_solve_batch(const uint8_t *puzzles, size_t count, uint8_t *out, int threads) {
+    BatchJob job = { .puzzles = puzzles, .out = out, .count = count };
+
+    // There's no point in a thread without a block of its own,
+    // so a batch of a single block is always solved right here.
+    size_t blocks = (count + BATCH_BLOCK - 1) / BATCH_BLOCK;
+    if (threads <= 0) threads = get_core_count();
+    if ((size_t) threads > blocks) threads = blocks ? (int) blocks : 1;
+
+    // If another batch has the pool, this one is solved on its own
+    // instead of waiting, on a board of its own.
+    if (pthread_mutex_trylock(&pool.busy) != 0) {
+        Board *board = calloc(1, sizeof(Board));
+        if (!board) return -1;
+        long solved = solve_blocks(&job, board);
+        free(board);
+        return solved;
+    }
+    if (threads == 1) {
+        long solved = solve_blocks(&job, &pool.board);
+        pthread_mutex_unlock(&pool.busy);
+        return solved;
+    }
+
+    pthread_once(&pool_once, start_pool);
+    pthread_mutex_lock(&pool.lock);
+    pool.job = &job;
+    pool.wanted = threads - 1 < pool.helper_count ? threads - 1 : pool.helper_count;
+    pool.running = pool.wanted;
+    ++pool.generation;
+    pthread_cond_broadcast(&pool.started);
+    pthread_mutex_unlock(&pool.lock);
+
+    long solved = solve_blocks(&job, &pool.board);
+
+    // The helpers only let go of the job once they're done with it.
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running) pthread_cond_wait(&pool.finished, &pool.lock);
+    pthread_mutex_unlock(&pool.lock);
+
+    solved += __atomic_load_n(&job.solved, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&pool.busy);
+    return solved;
+}
@@ -0,0 +1,117 @@
+#ifndef LIBSUDOKU_WFC_H
+#define LIBSUDOKU_WFC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The C API of libsudoku_wfc (make lib), for using the solver from other
+// programs. It only depends on this header: the board is opaque, and every
+// value crosses the API as a plain integer, so the layout of the solver's
+// own structs (which depends on how it was built) is never part of the ABI.
+// Functions are only ever added, and SUDOKU_API_VERSION only goes up when
+// one is, so a program works with any library at least as new as it is.
+//
+// A board's values go in and out as one byte per tile, in reading order:
+// 0 to width - 1 for a value, or SUDOKU_EMPTY for a tile that isn't
+// collapsed (or given). That's sudoku_board_size() bytes per board.
+//
+// A board is only safe to use from a single thread at a time,
+// but any number of boards can be used on different threads at once.
+#define SUDOKU_API_VERSION (1)
+#define SUDOKU_EMPTY (0xFF)
+
+// The same bits as the PASS_ flags in wfc.h.
+#define SUDOKU_PASS_HIDDEN_SINGLES (1u << 0)
+#define SUDOKU_PASS_NAKED_PAIRS (1u << 1)
+#define SUDOKU_PASS_POINTING_PAIRS (1u << 2)
+#define SUDOKU_PASS_ALL (0x7u)
+
+// The same as the ENGINE_ constants in dlx.h.
+#define SUDOKU_ENGINE_WFC (0)
+#define SUDOKU_ENGINE_DLX (1)
+#define SUDOKU_ENGINE_AUTO (2)
+
+// With the shared library only the functions declared here are exported.
+#if defined(__GNUC__)
+#define SUDOKU_API __attribute__((visibility("default")))
+#else
+#define SUDOKU_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SudokuBoard SudokuBoard;
+
+// What the library was built with: SUDOKU_API_VERSION, the width of
+// a board (9 for 9x9 boards), and the number of tiles on it.
+SUDOKU_API int sudoku_api_version(void);
+SUDOKU_API int sudoku_board_width(void);
+SUDOKU_API int sudoku_board_size(void);
+
+// Create an empty board, drawing its random numbers from the seed.
+// It solves with the WFC engine and no passes until told otherwise.
+// Returns NULL if there isn't enough memory.
+SUDOKU_API SudokuBoard *sudoku_create(uint64_t seed);
+SUDOKU_API void sudoku_destroy(SudokuBoard *board);
+
+// Set the passes the WFC engine runs (SUDOKU_PASS_ flags), and the engine
+// the board solves with. SUDOKU_ENGINE_AUTO picks WFC or DLX for every solve
+// (and count) by how many tiles are collapsed. Returns 0 for an unknown
+// engine (which auto is to libraries older than it), or if there isn't
+// enough memory for it, and 1 otherwise.
+SUDOKU_API void sudoku_set_passes(SudokuBoard *board, unsigned int passes);
+SUDOKU_API int sudoku_set_engine(SudokuBoard *board, int engine);
+
+// Reset every tile to every value, or set the board up with a puzzle's
+// givens. Setting a puzzle returns 0 if its givens contradict each other.
+SUDOKU_API void sudoku_reset(SudokuBoard *board);
+SUDOKU_API int sudoku_set_puzzle(SudokuBoard *board, const uint8_t *puzzle);
+
+// Collapse a tile to a value, and undo the last collapse (which can be
+// repeated back to the last reset). Collapsing returns:
+//  1 if the tile was collapsed, and the board can still be solved,
+//  0 if the tile was collapsed, but that left the board without a solution,
+//    in which case it should be undone,
+// -1 if the tile (or value) is out of range, or the value isn't one the
+//    tile can still take, in which case nothing changed.
+// Only 1 and 0 leave an undo mark, and 1 doesn't when the tile was already
+// collapsed to the value, since that changes nothing either.
+SUDOKU_API int sudoku_collapse(SudokuBoard *board, int x, int y, int value);
+SUDOKU_API void sudoku_undo(SudokuBoard *board);
+
+// Solve the board from where it is, returning 1 if it was solved,
+// or 0 (leaving the board as it was) if it has no solution.
+SUDOKU_API int sudoku_solve(SudokuBoard *board);
+
+// Count the board's solutions, stopping at limit (2 is enough to tell
+// whether a puzzle is unique). The board isn't changed.
+// Returns -1 without searching if the limit is less than 1.
+SUDOKU_API int sudoku_count_solutions(SudokuBoard *board, int limit);
+
+// Write the board's values (SUDOKU_EMPTY for tiles that aren't collapsed).
+SUDOKU_API void sudoku_get_values(SudokuBoard *board, uint8_t *values);
+
+// Reset the board and solve it, writing a new random solved board.
+SUDOKU_API void sudoku_generate(SudokuBoard *board, uint8_t *values);
+
+// Solve count puzzles, read straight out of the puzzles buffer and
+// written straight into the out buffer (both count boards long), with
+// SUDOKU_EMPTY for every tile of a puzzle without a solution.
+// The puzzles are handed out to the threads (0 for one per core) in blocks
+// of 64, with the calling thread as one of them. The other threads are
+// started by the first batch that needs them and kept for the next ones,
+// and a batch of a single block (or a single thread) never uses them.
+// Only one batch at a time uses them, so a batch started while another is
+// running is solved on the calling thread alone.
+// They're solved with the WFC engine and every pass, and each one seeded
+// by its index, so the solutions don't depend on the threads.
+// Returns the number of puzzles solved, or -1 if there wasn't enough memory.
+SUDOKU_API long sudoku_solve_batch(const uint8_t *puzzles, size_t count, uint8_t *out, int threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LIBSUDOKU_WFC_H
@@ -0,0 +1,131 @@
+#include <string.h>
+#include "packed.h"
+
+static const uint8_t magic[4] = { 'S', 'W', 'F', 'B' };
+
+static void write_le(uint8_t *out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) out[i] = (uint8_t) (value >> (i * 8));
+}
+
+static uint64_t read_le(const uint8_t *in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) value |= (uint64_t) in[i] << (i * 8);
+    return value;
+}
+
+void write_packed_header(uint8_t header[PACKED_HEADER_SIZE], uint64_t count) {
+    memcpy(header, magic, sizeof(magic));
+    write_le(header + 4, PACKED_VERSION, 4);
+    write_le(header + 8, BOARD_WIDTH, 4);
+    write_le(header + 12, PACKED_RECORD_SIZE, 4);
+    write_le(header + 16, count, 8);
+    write_le(header + 24, PACKED_HEADER_SIZE, 8);
+}
+
+bool read_packed_header(const uint8_t *data, size_t size, PackedHeader *packed) {
+    if (size < PACKED_HEADER_SIZE || memcmp(data, magic, sizeof(magic)) != 0) return false;
+
+    packed->version = (uint32_t) read_le(data + 4, 4);
+    packed->board_width = (uint32_t) read_le(data + 8, 4);
+    packed->record_size = (uint32_t) read_le(data + 12, 4);
+    packed->count = read_le(data + 16, 8);
+    packed->data_offset = read_le(data + 24, 8);
+
+    return packed->version == PACKED_VERSION
+        && packed->board_width == BOARD_WIDTH
+        && packed->record_size == PACKED_RECORD_SIZE
+        && packed->data_offset >= PACKED_HEADER_SIZE;
+}
+
+// The stored tiles are every row but the last, without its last tile.
+static int get_packed_tile(int n) {
+    return n / (BOARD_WIDTH - 1) * BOARD_WIDTH + n % (BOARD_WIDTH - 1);
+}
+
+// The bytes word w of a record takes. Only the last word can be short.
+static int get_word_bytes(int w) {
+    int full_words = PACKED_TILES / PACKED_WORD_DIGITS;
+    return w < full_words ? 8 : PACKED_RECORD_SIZE - full_words * 8;
+}
+
+void pack_solution(const Solution *solution, uint8_t record[PACKED_RECORD_SIZE]) {
+    if (!solution->solved) {
+        memset(record, 0xFF, PACKED_RECORD_SIZE);
+        return;
+    }
+
+    uint8_t *out = record;
+    for (int w = 0; w * PACKED_WORD_DIGITS < PACKED_TILES; ++w) {
+        // The first digit of a word ends up the most significant.
+        int first = w * PACKED_WORD_DIGITS;
+        int last = first + PACKED_WORD_DIGITS < PACKED_TILES ? first + PACKED_WORD_DIGITS : PACKED_TILES;
+        uint64_t word = 0;
+        for (int n = first; n < last; ++n) word = word * TILE_STATES + solution->values[get_packed_tile(n)];
+
+        write_le(out, word, get_word_bytes(w));
+        out += get_word_bytes(w);
+    }
+}
+
+bool unpack_solution(const uint8_t record[PACKED_RECORD_SIZE], Solution *solution) {
+    solution->solved = false;
+
+    const uint8_t *in = record;
+    for (int w = 0; w * PACKED_WORD_DIGITS < PACKED_TILES; ++w) {
+        int first = w * PACKED_WORD_DIGITS;
+        int last = first + PACKED_WORD_DIGITS < PACKED_TILES ? first + PACKED_WORD_DIGITS : PACKED_TILES;
+        uint64_t word = read_le(in, get_word_bytes(w));
+        in += get_word_bytes(w);
+
+        for (int n = last - 1; n >= first; --n) {
+            solution->values[get_packed_tile(n)] = (uint8_t) (word % TILE_STATES);
+            word /= TILE_STATES;
+        }
+
+        // Anything left over means the word was too big to be digits,
+        // which includes the record of a puzzle without a solution.
+        if (word) return false;
+    }
+
+    // Fill in the value missing from every row, then from every column.
+    const unsigned int all_values = (1u << TILE_STATES) - 1;
+    for (int y = 0; y < BOARD_WIDTH - 1; ++y) {
+        unsigned int seen = 0;
+        for (int x = 0; x < BOARD_WIDTH - 1; ++x) seen |= 1u << solution->values[y * BOARD_WIDTH + x];
+        if (count_bits(seen) != BOARD_WIDTH - 1) return false;
+        solution->values[y * BOARD_WIDTH + BOARD_WIDTH - 1] = (uint8_t) lowest_bit(all_values & ~seen);
+    }
+    for (int x = 0; x < BOARD_WIDTH; ++x) {
+        unsigned int seen = 0;
+        for (int y = 0; y < BOARD_WIDTH - 1; ++y) seen |= 1u << solution->values[y * BOARD_WIDTH + x];
+        if (count_bits(seen) != BOARD_WIDTH - 1) return false;
+        solution->values[(BOARD_WIDTH - 1) * BOARD_WIDTH + x] = (uint8_t) lowest_bit(all_values & ~seen);
+    }
+
+    // The last row and the boxes still have to work out.
+    unsigned int last_row = 0;
+    for (int x = 0; x < BOARD_WIDTH; ++x) last_row |= 1u << solution->values[(BOARD_WIDTH - 1) * BOARD_WIDTH + x];
+    if (last_row != all_values) return false;
+
+    for (int box = 0; box < BOARD_WIDTH; ++box) {
+        unsigned int seen = 0;
+        for (int k = 0; k < BOARD_WIDTH; ++k) {
+            int y = box / BOX_WIDTH * BOX_WIDTH + k / BOX_WIDTH;
+            int x = box % BOX_WIDTH * BOX_WIDTH + k % BOX_WIDTH;
+            seen |= 1u << solution->values[y * BOARD_WIDTH + x];
+        }
+        if (seen != all_values) return false;
+    }
+
+    solution->solved = true;
+    return true;
+}
+
+const uint8_t *get_packed_record(const uint8_t *data, size_t size, const PackedHeader *packed, uint64_t k) {
+    if (packed->count != PACKED_UNKNOWN_COUNT && k >= packed->count) return NULL;
+
+    // Check against the size without overflowing for a huge k.
+    if (packed->data_offset > size) return NULL;
+    if (k >= (size - packed->data_offset) / packed->record_size) return NULL;
+    return data + packed->data_offset + k * packed->record_size;
+}
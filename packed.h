@@ -0,0 +1,77 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "generator.h"
+
+// A binary file of solved boards, for writing boards out in bulk.
+//
+// The file starts with a PACKED_HEADER_SIZE byte header (all integers
+// little endian), followed by one fixed size record per board:
+//
+//   offset  size  field
+//        0     4  magic, "SWFB"
+//        4     4  version, PACKED_VERSION
+//        8     4  board width, BOARD_WIDTH
+//       12     4  record size, PACKED_RECORD_SIZE
+//       16     8  number of boards, or PACKED_UNKNOWN_COUNT if the file
+//                 couldn't be rewritten after the boards were
+//       24     8  offset of the first record
+//
+// Every record is the same size, so board k is at
+// first record + k * record size, and the file can be mapped and
+// read from anywhere without an index of its own.
+//
+// A solved board is fully determined by the tiles outside of its last row
+// and column (which are whatever value is missing from each row and column),
+// so only those are stored, as base TILE_STATES digits packed into 64-bit
+// words, PACKED_WORD_DIGITS at a time. A record of all 0xFF bytes is
+// a (solve mode) puzzle without a solution.
+
+#define PACKED_VERSION (1)
+#define PACKED_HEADER_SIZE (32)
+#define PACKED_UNKNOWN_COUNT (UINT64_MAX)
+
+#define PACKED_TILES ((BOARD_WIDTH - 1) * (BOARD_WIDTH - 1))
+
+// The number of digits that fit in a word, and the bytes the
+// PACKED_TILES digits take:
+// 9x9: 9^20 < 2^64, 64 digits take 3 words and the last 4 need 2 bytes.
+// 16x16: 16^16 = 2^64, 225 digits take 14 words and the last one a byte.
+// 25x25: 25^13 < 2^64, 576 digits take 44 words and the last 4 need 3 bytes.
+#if TILE_STATES == 9
+#define PACKED_WORD_DIGITS (20)
+#define PACKED_RECORD_SIZE (26)
+#elif TILE_STATES == 16
+#define PACKED_WORD_DIGITS (16)
+#define PACKED_RECORD_SIZE (113)
+#elif TILE_STATES == 25
+#define PACKED_WORD_DIGITS (13)
+#define PACKED_RECORD_SIZE (355)
+#else
+#error "There is no packed record layout for this TILE_STATES"
+#endif
+
+typedef struct PackedHeader {
+    uint32_t version;
+    uint32_t board_width;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t data_offset;
+} PackedHeader;
+
+void write_packed_header(uint8_t header[PACKED_HEADER_SIZE], uint64_t count);
+
+// Returns false if the data doesn't start with a header this build can read.
+bool read_packed_header(const uint8_t *data, size_t size, PackedHeader *packed);
+
+void pack_solution(const Solution *solution, uint8_t record[PACKED_RECORD_SIZE]);
+
+// Returns false if the record isn't a solved board.
+bool unpack_solution(const uint8_t record[PACKED_RECORD_SIZE], Solution *solution);
+
+// Get the record of board k, or NULL if the file is too short for it.
+const uint8_t *get_packed_record(const uint8_t *data, size_t size, const PackedHeader *packed, uint64_t k);
+
+#endif // PACKED_H
@@ -0,0 +1,141 @@
+#ifndef PEERS_H
+#define PEERS_H
+
+#include <stdint.h>
+#include "wfc.h"
+
+// The peers of a tile are the other tiles in its row, column and box,
+// which are the tiles a collapse has to constrain.
+// peers[i] lists all PEER_COUNT of them for tile i, so propagating a
+// constraint is a single loop over a row of this table.
+//
+// C has no constexpr, so the table is written out by the preprocessor:
+// PEER_INDEX computes the k-th peer of tile i as a constant expression,
+// and the REPEAT macros below stamp it out for every i and k.
+
+// Every tile in the row and column but itself,
+// plus the tiles in its box that aren't already in its row or column.
+#define PEER_COUNT (2 * (BOARD_WIDTH - 1) + (BOX_WIDTH - 1) * (BOX_WIDTH - 1))
+
+// The counts above, one decimal digit at a time (hundreds, tens, units),
+// which is how the REPEAT macros need them.
+#if BOX_WIDTH == 3
+#define BOARD_SIZE_DIGITS 0, 8, 1
+#define PEER_COUNT_DIGITS 0, 2, 0
+#elif BOX_WIDTH == 4
+#define BOARD_SIZE_DIGITS 2, 5, 6
+#define PEER_COUNT_DIGITS 0, 3, 9
+#elif BOX_WIDTH == 5
+#define BOARD_SIZE_DIGITS 6, 2, 5
+#define PEER_COUNT_DIGITS 0, 6, 4
+#else
+#error "There are no peer table digits for this BOX_WIDTH"
+#endif
+
+#define PEER_ROW_OF(i) ((i) / BOARD_WIDTH)
+#define PEER_COLUMN_OF(i) ((i) % BOARD_WIDTH)
+
+// The n-th of BOARD_WIDTH - 1 indices from 0 to BOARD_WIDTH - 1, skipping `skip`.
+#define PEER_SKIP(n, skip) ((n) + ((n) >= (skip)))
+
+// Peers 0 to BOARD_WIDTH - 2 are the rest of the tile's row.
+#define PEER_IN_ROW(i, k) \
+    (PEER_ROW_OF(i) * BOARD_WIDTH + PEER_SKIP(k, PEER_COLUMN_OF(i)))
+
+// The next BOARD_WIDTH - 1 peers are the rest of the tile's column.
+#define PEER_IN_COLUMN(i, k) \
+    (PEER_SKIP(k, PEER_ROW_OF(i)) * BOARD_WIDTH + PEER_COLUMN_OF(i))
+
+// The rest are the tiles in the box on other rows and columns.
+#define PEER_IN_BOX(i, k) ( \
+    (PEER_ROW_OF(i) / BOX_WIDTH * BOX_WIDTH \
+        + PEER_SKIP((k) / (BOX_WIDTH - 1), PEER_ROW_OF(i) % BOX_WIDTH)) * BOARD_WIDTH \
+    + PEER_COLUMN_OF(i) / BOX_WIDTH * BOX_WIDTH \
+        + PEER_SKIP((k) % (BOX_WIDTH - 1), PEER_COLUMN_OF(i) % BOX_WIDTH))
+
+#define PEER_INDEX(i, k) \
+    ((k) < BOARD_WIDTH - 1 ? PEER_IN_ROW(i, k) \
+    : (k) < 2 * (BOARD_WIDTH - 1) ? PEER_IN_COLUMN(i, (k) - (BOARD_WIDTH - 1)) \
+    : PEER_IN_BOX(i, (k) - 2 * (BOARD_WIDTH - 1)))
+
+// REPEAT(digits, M, d) expands to M(d, 0) M(d, 1) ... M(d, n - 1),
+// where the digits spell out n. There are two identical sets of them
+// because a macro can't be used again inside its own expansion,
+// and the table needs one loop nested in another.
+#define TILE_U0(M, d, b)
+#define TILE_U1(M, d, b) M(d, b)
+#define TILE_U2(M, d, b) TILE_U1(M, d, b) M(d, b + 1)
+#define TILE_U3(M, d, b) TILE_U2(M, d, b) M(d, b + 2)
+#define TILE_U4(M, d, b) TILE_U3(M, d, b) M(d, b + 3)
+#define TILE_U5(M, d, b) TILE_U4(M, d, b) M(d, b + 4)
+#define TILE_U6(M, d, b) TILE_U5(M, d, b) M(d, b + 5)
+#define TILE_U7(M, d, b) TILE_U6(M, d, b) M(d, b + 6)
+#define TILE_U8(M, d, b) TILE_U7(M, d, b) M(d, b + 7)
+#define TILE_U9(M, d, b) TILE_U8(M, d, b) M(d, b + 8)
+#define TILE_U10(M, d, b) TILE_U9(M, d, b) M(d, b + 9)
+#define TILE_T0(M, d, b)
+#define TILE_T1(M, d, b) TILE_U10(M, d, b)
+#define TILE_T2(M, d, b) TILE_T1(M, d, b) TILE_U10(M, d, b + 10)
+#define TILE_T3(M, d, b) TILE_T2(M, d, b) TILE_U10(M, d, b + 20)
+#define TILE_T4(M, d, b) TILE_T3(M, d, b) TILE_U10(M, d, b + 30)
+#define TILE_T5(M, d, b) TILE_T4(M, d, b) TILE_U10(M, d, b + 40)
+#define TILE_T6(M, d, b) TILE_T5(M, d, b) TILE_U10(M, d, b + 50)
+#define TILE_T7(M, d, b) TILE_T6(M, d, b) TILE_U10(M, d, b + 60)
+#define TILE_T8(M, d, b) TILE_T7(M, d, b) TILE_U10(M, d, b + 70)
+#define TILE_T9(M, d, b) TILE_T8(M, d, b) TILE_U10(M, d, b + 80)
+#define TILE_T10(M, d, b) TILE_T9(M, d, b) TILE_U10(M, d, b + 90)
+#define TILE_H0(M, d, b)
+#define TILE_H1(M, d, b) TILE_T10(M, d, b)
+#define TILE_H2(M, d, b) TILE_H1(M, d, b) TILE_T10(M, d, b + 100)
+#define TILE_H3(M, d, b) TILE_H2(M, d, b) TILE_T10(M, d, b + 200)
+#define TILE_H4(M, d, b) TILE_H3(M, d, b) TILE_T10(M, d, b + 300)
+#define TILE_H5(M, d, b) TILE_H4(M, d, b) TILE_T10(M, d, b + 400)
+#define TILE_H6(M, d, b) TILE_H5(M, d, b) TILE_T10(M, d, b + 500)
+#define TILE_REPEAT(digits, M, d) TILE_REPEAT_DIGITS(digits, M, d)
+#define TILE_REPEAT_DIGITS(h, t, u, M, d) \
+    TILE_H##h(M, d, 0) TILE_T##t(M, d, h * 100) TILE_U##u(M, d, h * 100 + t * 10)
+
+#define PEER_U0(M, d, b)
+#define PEER_U1(M, d, b) M(d, b)
+#define PEER_U2(M, d, b) PEER_U1(M, d, b) M(d, b + 1)
+#define PEER_U3(M, d, b) PEER_U2(M, d, b) M(d, b + 2)
+#define PEER_U4(M, d, b) PEER_U3(M, d, b) M(d, b + 3)
+#define PEER_U5(M, d, b) PEER_U4(M, d, b) M(d, b + 4)
+#define PEER_U6(M, d, b) PEER_U5(M, d, b) M(d, b + 5)
+#define PEER_U7(M, d, b) PEER_U6(M, d, b) M(d, b + 6)
+#define PEER_U8(M, d, b) PEER_U7(M, d, b) M(d, b + 7)
+#define PEER_U9(M, d, b) PEER_U8(M, d, b) M(d, b + 8)
+#define PEER_U10(M, d, b) PEER_U9(M, d, b) M(d, b + 9)
+#define PEER_T0(M, d, b)
+#define PEER_T1(M, d, b) PEER_U10(M, d, b)
+#define PEER_T2(M, d, b) PEER_T1(M, d, b) PEER_U10(M, d, b + 10)
+#define PEER_T3(M, d, b) PEER_T2(M, d, b) PEER_U10(M, d, b + 20)
+#define PEER_T4(M, d, b) PEER_T3(M, d, b) PEER_U10(M, d, b + 30)
+#define PEER_T5(M, d, b) PEER_T4(M, d, b) PEER_U10(M, d, b + 40)
+#define PEER_T6(M, d, b) PEER_T5(M, d, b) PEER_U10(M, d, b + 50)
+#define PEER_T7(M, d, b) PEER_T6(M, d, b) PEER_U10(M, d, b + 60)
+#define PEER_T8(M, d, b) PEER_T7(M, d, b) PEER_U10(M, d, b + 70)
+#define PEER_T9(M, d, b) PEER_T8(M, d, b) PEER_U10(M, d, b + 80)
+#define PEER_T10(M, d, b) PEER_T9(M, d, b) PEER_U10(M, d, b + 90)
+#define PEER_H0(M, d, b)
+#define PEER_H1(M, d, b) PEER_T10(M, d, b)
+#define PEER_H2(M, d, b) PEER_H1(M, d, b) PEER_T10(M, d, b + 100)
+#define PEER_H3(M, d, b) PEER_H2(M, d, b) PEER_T10(M, d, b + 200)
+#define PEER_H4(M, d, b) PEER_H3(M, d, b) PEER_T10(M, d, b + 300)
+#define PEER_H5(M, d, b) PEER_H4(M, d, b) PEER_T10(M, d, b + 400)
+#define PEER_H6(M, d, b) PEER_H5(M, d, b) PEER_T10(M, d, b + 500)
+#define PEER_REPEAT(digits, M, d) PEER_REPEAT_DIGITS(digits, M, d)
+#define PEER_REPEAT_DIGITS(h, t, u, M, d) \
+    PEER_H##h(M, d, 0) PEER_T##t(M, d, h * 100) PEER_U##u(M, d, h * 100 + t * 10)
+
+#define PEER_ENTRY(i, k) (TileIndex) PEER_INDEX(i, k),
+#define PEER_TABLE_ROW(unused, i) { PEER_REPEAT(PEER_COUNT_DIGITS, PEER_ENTRY, i) },
+
+static const TileIndex peers[][PEER_COUNT] = {
+    TILE_REPEAT(BOARD_SIZE_DIGITS, PEER_TABLE_ROW, 0)
+};
+
+// Fails to compile if the digits don't match BOARD_SIZE.
+typedef char peer_table_size_check[sizeof(peers) == sizeof(TileIndex) * BOARD_SIZE * PEER_COUNT ? 1 : -1];
+
+#endif // PEERS_H
@@ -0,0 +1,95 @@
+// pthread needs POSIX.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "portfolio.h"
+#include "puzzles.h"
+
+typedef struct Race {
+    // The index of the first racer to finish, or -1 until one has.
+    int winner;
+} Race;
+
+typedef struct Racer {
+    Board board;
+    SolveState solve;
+    Random random;
+    pthread_t thread;
+
+    int index;
+    Race *race;
+    const uint8_t *puzzle;
+} Racer;
+
+// Solve until this racer finishes or another one has,
+// claiming the win if it gets there first.
+static void run_race(Race *race, int index, Board *board, SolveState *solve, Random *random) {
+    while (__atomic_load_n(&race->winner, __ATOMIC_ACQUIRE) < 0) {
+        if (continue_solve(board, solve, random, RACE_STEPS) == SOLVE_RUNNING) continue;
+
+        int expected = -1;
+        __atomic_compare_exchange_n(&race->winner, &expected, index, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+        return;
+    }
+}
+
+static void *run_racer(void *data) {
+    Racer *racer = data;
+
+    // The puzzle was loaded once already, so its givens can't contradict,
+    // but the passes of another heuristic may still find the puzzle has
+    // no solution right away, which finishes the race just the same.
+    set_puzzle(&racer->board, racer->puzzle);
+    start_solve(&racer->board, &racer->solve);
+    run_race(racer->race, racer->index, &racer->board, &racer->solve, &racer->random);
+    return NULL;
+}
+
+SolveStatus race_solve(
+    Board *board, SolveState *solve, Random *random,
+    const uint8_t puzzle[BOARD_SIZE], int racers, uint64_t seed, Solution *solution
+) {
+    Race race = { .winner = -1 };
+
+    // Without the memory for the other racers, racer 0 races alone.
+    int other_count = racers > 1 ? racers - 1 : 0;
+    Racer *others = other_count ? calloc((size_t) other_count, sizeof(Racer)) : NULL;
+
+    int combinations = SELECTION_COUNT * ORDERING_COUNT;
+    int combination = board->selection * ORDERING_COUNT + board->ordering;
+    int started = 0;
+    for (; others && started < other_count; ++started) {
+        Racer *racer = &others[started];
+        int heuristics = (combination + started + 1) % combinations;
+        racer->board.passes = board->passes;
+        racer->board.selection = heuristics / ORDERING_COUNT;
+        racer->board.ordering = heuristics % ORDERING_COUNT;
+        seed_random(&racer->random, seed, (uint64_t) started + 1);
+        racer->index = started + 1;
+        racer->race = &race;
+        racer->puzzle = puzzle;
+
+        if (pthread_create(&racer->thread, NULL, run_racer, racer) != 0) break;
+    }
+
+    run_race(&race, 0, board, solve, random);
+    for (int i = 0; i < started; ++i) pthread_join(others[i].thread, NULL);
+
+    // Every racer has stopped, so the winner's board can be read.
+    Board *winner = race.winner == 0 ? board : &others[race.winner - 1].board;
+    SolveStatus status = race.winner == 0 ? solve->status : others[race.winner - 1].solve.status;
+    solution->solved = false;
+    if (status == SOLVE_SOLVED) get_solution(winner, solution);
+
+    if (winner != board) {
+        board->backtracks = winner->backtracks;
+        for (int pass = 0; pass < PASS_COUNT; ++pass) board->pass_changes[pass] = winner->pass_changes[pass];
+    }
+#if SOLVER_STATS
+    for (int i = 0; i < started; ++i) add_solver_stats(&board->stats, &others[i].board.stats);
+#endif
+
+    free(others);
+    return status;
+}
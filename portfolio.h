@@ -0,0 +1,34 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <stdint.h>
+#include "generator.h"
+
+// Solving a single hard puzzle on several threads at once, by racing
+// solvers that search it in different orders against each other.
+// How long a search takes depends far more on the order it tries things in
+// than on anything else, so the fastest of a few different searches
+// is usually much faster than any one of them.
+//
+// Racer 0 is the solve the race is started from, carried on where it was
+// on the calling thread. Every other racer solves the puzzle on a board of
+// its own, on its own thread, with its own random stream and the next
+// combination of the SELECT_ and ORDER_ heuristics after the board's.
+// The first racer to finish wins (a search that runs out of values has
+// proven there's no solution, which is as good as finding one),
+// and the others stop the next time they check, every RACE_STEPS steps.
+#define RACE_STEPS (256)
+
+// Finish a solve that was started on a board loaded with a puzzle
+// (see start_solve and set_puzzle) by racing it against racers - 1 others.
+// If the puzzle is solved, the winner's values are written to the solution.
+// Either way the board's backtracks and pass changes are set to the
+// winner's, but its tiles are only left solved if racer 0 won.
+// Racer i other than 0 draws its random numbers from stream i of the seed.
+// If a racer's thread can't be started, the race goes on without it.
+SolveStatus race_solve(
+    Board *board, SolveState *solve, Random *random,
+    const uint8_t puzzle[BOARD_SIZE], int racers, uint64_t seed, Solution *solution
+);
+
+#endif // PORTFOLIO_H
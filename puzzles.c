@@ -0,0 +1,372 @@
+// mmap and sched_yield are POSIX, not C99.
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "portfolio.h"
+#include "puzzles.h"
+#include "queue.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The number of bytes of the file in each chunk, before it's moved
+// to the start of a line. A chunk has to hold fewer puzzles than a queue
+// (82 bytes each on a 9x9 board), or its worker would wait for the consumer to reach it
+// before it could get through the chunk.
+#define CHUNK_SIZE (64 * 1024)
+
+bool read_puzzle(const char *text, size_t length, uint8_t puzzle[BOARD_SIZE]) {
+    if (length != BOARD_SIZE) return false;
+
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        char given = text[i];
+        int value = get_char_value(given);
+        if (given == '0' || given == '.') puzzle[i] = EMPTY_TILE;
+        else if (value < 0) return false;
+        else puzzle[i] = (uint8_t) value;
+    }
+    return true;
+}
+
+bool load_puzzle(Board *board, const char *text, size_t length) {
+    uint8_t puzzle[BOARD_SIZE];
+    return read_puzzle(text, length, puzzle) && set_puzzle(board, puzzle);
+}
+
+bool set_puzzle(Board *board, const uint8_t puzzle[BOARD_SIZE]) {
+    reset_tiles(board);
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        if (puzzle[i] == EMPTY_TILE) continue;
+
+        int x = i % BOARD_WIDTH;
+        int y = i / BOARD_WIDTH;
+        if (!collapse_tile(board, x, y, puzzle[i])) return false;
+    }
+    return true;
+}
+
+// A given can be removed as long as no other value of its tile
+// leads to a solution, since the puzzle already has one with its value.
+// That needs a single search with the value taken out, which stops at the
+// first solution it finds, instead of counting up to two without it.
+//
+// The givens that haven't been tried yet are collapsed once, in reverse,
+// so the next one to try is always on top of the trail and removing it
+// is a rollback. Only the givens that were kept are collapsed again.
+int dig_puzzle(Board *board, int engine, DlxSolver *dlx, Random *random, Solution *puzzle) {
+    TileIndex order[BOARD_SIZE];
+    for (int i = 0; i < BOARD_SIZE; ++i) order[i] = (TileIndex) i;
+    for (int i = BOARD_SIZE - 1; i > 0; --i) {
+        int j = get_random_value(random, 0, i);
+        TileIndex swap = order[i];
+        order[i] = order[j];
+        order[j] = swap;
+    }
+
+    // An empty board can take any solved board's values.
+    int marks[BOARD_SIZE];
+    reset_tiles(board);
+    for (int k = BOARD_SIZE - 1; k >= 0; --k) {
+        marks[k] = board->trail_size;
+        collapse_tile(board, order[k] % BOARD_WIDTH, order[k] / BOARD_WIDTH, puzzle->values[order[k]]);
+    }
+
+    TileIndex kept[BOARD_SIZE];
+    int kept_count = 0;
+    for (int k = 0; k < BOARD_SIZE; ++k) {
+        rollback_tiles(board, marks[k]);
+        for (int j = 0; j < kept_count; ++j) {
+            collapse_tile(board, kept[j] % BOARD_WIDTH, kept[j] / BOARD_WIDTH, puzzle->values[kept[j]]);
+        }
+
+        int x = order[k] % BOARD_WIDTH;
+        int y = order[k] / BOARD_WIDTH;
+        int trail_size = board->trail_size;
+        bool unique = !constrain_tile(board, x, y, puzzle->values[order[k]])
+            || count_with_engine(engine, dlx, board, 1) == 0;
+        rollback_tiles(board, trail_size);
+
+        if (unique) puzzle->values[order[k]] = EMPTY_TILE;
+        else kept[kept_count++] = order[k];
+    }
+
+    return kept_count;
+}
+
+bool open_puzzles(PuzzleFile *file, const char *path) {
+    *file = (PuzzleFile) { 0 };
+
+#ifdef _WIN32
+    // Without mmap, read the whole file in one go instead.
+    FILE *in = fopen(path, "rb");
+    if (!in) return false;
+
+    bool read = fseek(in, 0, SEEK_END) == 0;
+    long size = read ? ftell(in) : -1;
+    char *data = size > 0 ? malloc((size_t) size) : NULL;
+    read = size >= 0 && fseek(in, 0, SEEK_SET) == 0;
+    if (read && size > 0) read = data && fread(data, 1, (size_t) size, in) == (size_t) size;
+    fclose(in);
+
+    if (!read) {
+        free(data);
+        return false;
+    }
+    file->data = data;
+    file->size = (size_t) size;
+#else
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor < 0) return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        close(descriptor);
+        return false;
+    }
+
+    // An empty file can't be mapped, but it has no puzzles to read anyway.
+    file->size = (size_t) status.st_size;
+    if (file->size) {
+        void *data = mmap(NULL, file->size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED) {
+            close(descriptor);
+            return false;
+        }
+
+        // The workers read their chunks front to back.
+        posix_madvise(data, file->size, POSIX_MADV_SEQUENTIAL);
+        file->data = data;
+    }
+
+    // The mapping stays valid after the file is closed.
+    close(descriptor);
+#endif
+
+    return true;
+}
+
+void close_puzzles(PuzzleFile *file) {
+#ifdef _WIN32
+    free((void *) file->data);
+#else
+    if (file->size) munmap((void *) file->data, file->size);
+#endif
+    *file = (PuzzleFile) { 0 };
+}
+
+typedef struct Chunk {
+    // The number of puzzles in the chunk, or -1 until its worker
+    // has solved all of them.
+    long puzzles;
+} Chunk;
+
+typedef struct PuzzleWorker {
+    SolutionQueue queue;
+    Board board;
+    pthread_t thread;
+    int engine;
+    DlxSolver dlx;
+
+    const PuzzleFile *file;
+    Chunk *chunks;
+    long chunk_count;
+
+    // Worker i solves chunks i, i + stride, i + stride * 2, ...
+    long first_chunk;
+    long stride;
+
+    uint64_t seed;
+    SolveCache *cache;
+
+    // Puzzles left unsolved after race_steps steps are raced on racers threads.
+    long race_steps;
+    int racers;
+    GeneratorStats stats;
+} PuzzleWorker;
+
+// Find the start of the first line that starts at or after an offset.
+// Each line belongs to the chunk it starts in.
+static const char *find_line(const PuzzleFile *file, size_t offset) {
+    if (offset == 0) return file->data;
+    if (offset >= file->size) return file->data + file->size;
+
+    const char *newline = memchr(file->data + offset - 1, '\n', file->size - offset + 1);
+    return newline ? newline + 1 : file->data + file->size;
+}
+
+// Solve a loaded puzzle, on the worker alone for its first race_steps steps,
+// and then by racing it if it's still going. Each race is seeded with
+// the offset of the puzzle's line, so every puzzle gets its own racers.
+static bool solve_loaded(PuzzleWorker *worker, Random *random, const uint8_t puzzle[BOARD_SIZE], uint64_t offset, Solution *solution) {
+    Board *board = &worker->board;
+    int engine = resolve_engine(worker->engine, board);
+    if (!worker->race_steps || engine != ENGINE_WFC) {
+        bool solved = solve_with_engine(engine, &worker->dlx, board, random);
+        if (solved) get_solution(board, solution);
+        return solved;
+    }
+
+    SolveState solve;
+    SolveStatus status = start_solve(board, &solve);
+    if (status == SOLVE_RUNNING) status = continue_solve(board, &solve, random, worker->race_steps);
+
+    if (status == SOLVE_RUNNING) {
+        ++worker->stats.races;
+        return race_solve(board, &solve, random, puzzle, worker->racers, worker->seed + offset, solution) == SOLVE_SOLVED;
+    }
+    if (status == SOLVE_SOLVED) get_solution(board, solution);
+    return status == SOLVE_SOLVED;
+}
+
+// Solve a puzzle, or find it in the cache if there is one.
+static void solve_line(PuzzleWorker *worker, Random *random, const char *line, size_t length, Solution *solution) {
+    uint8_t puzzle[BOARD_SIZE];
+    CacheLookup lookup;
+    bool read = read_puzzle(line, length, puzzle);
+    bool cached = worker->cache && read;
+    if (cached && find_solution(worker->cache, puzzle, solution, &lookup)) {
+        ++worker->stats.cache_hits;
+        return;
+    }
+
+    uint64_t offset = (uint64_t) (line - worker->file->data);
+    bool loaded = read && set_puzzle(&worker->board, puzzle);
+    solution->solved = loaded && solve_loaded(worker, random, puzzle, offset, solution);
+    if (loaded) add_board_stats(&worker->stats, &worker->board);
+
+    // Only puzzles that could be read were looked up.
+    if (cached && loaded) add_solution(worker->cache, puzzle, &lookup, solution);
+}
+
+static long solve_chunk(PuzzleWorker *worker, long chunk) {
+    const char *line = find_line(worker->file, (size_t) chunk * CHUNK_SIZE);
+    const char *end = find_line(worker->file, (size_t) (chunk + 1) * CHUNK_SIZE);
+
+    Random random;
+    seed_random(&random, worker->seed, (uint64_t) chunk);
+
+    long puzzles = 0;
+    while (line < end) {
+        const char *newline = memchr(line, '\n', (size_t) (end - line));
+        const char *next = newline ? newline + 1 : end;
+        size_t length = (size_t) ((newline ? newline : end) - line);
+        if (length && line[length - 1] == '\r') --length;
+
+        if (length) {
+            solve_line(worker, &random, line, length, reserve_solution(&worker->queue));
+            push_solution(&worker->queue);
+            ++puzzles;
+        }
+        line = next;
+    }
+
+    return puzzles;
+}
+
+static void *run_puzzle_worker(void *data) {
+    PuzzleWorker *worker = data;
+
+    for (long chunk = worker->first_chunk; chunk < worker->chunk_count; chunk += worker->stride) {
+        long puzzles = solve_chunk(worker, chunk);
+
+        // Every solution in the chunk has been pushed before this is seen.
+        __atomic_store_n(&worker->chunks[chunk].puzzles, puzzles, __ATOMIC_RELEASE);
+    }
+
+#if SOLVER_STATS
+    worker->stats.solver = worker->board.stats;
+#endif
+    return NULL;
+}
+
+// Pass every solution of a chunk to the callback (if there is one),
+// waiting for the worker to get through it.
+static void drain_chunk(PuzzleWorker *worker, Chunk *chunk, SolutionCallback callback, void *user_data) {
+    long consumed = 0;
+    while (true) {
+        // The worker only gets to its next chunk after publishing the count
+        // for this one, so checking the count after the queue makes sure
+        // none of the next chunk's solutions are taken for this one's.
+        const Solution *solution = try_peek_solution(&worker->queue);
+        long puzzles = __atomic_load_n(&chunk->puzzles, __ATOMIC_ACQUIRE);
+        if (puzzles >= 0 && consumed == puzzles) return;
+
+        if (!solution) {
+            sched_yield();
+            continue;
+        }
+        if (callback) callback(solution, user_data);
+        pop_solution(&worker->queue);
+        ++consumed;
+    }
+}
+
+bool solve_puzzles(
+    const PuzzleFile *file, const GeneratorOptions *options,
+    SolutionCallback callback, void *user_data, GeneratorStats *stats
+) {
+    *stats = (GeneratorStats) { 0 };
+
+    long chunk_count = (long) ((file->size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    if (chunk_count == 0) return true;
+
+    // Racing puzzles takes every thread, so one worker goes through them all.
+    int racers = options->threads < 1 ? 1 : options->threads;
+    int threads = options->race_steps ? 1 : racers;
+    if (threads > chunk_count) threads = (int) chunk_count;
+
+    Chunk *chunks = malloc((size_t) chunk_count * sizeof(Chunk));
+    PuzzleWorker *workers = calloc((size_t) threads, sizeof(PuzzleWorker));
+    if (!chunks || !workers) {
+        free(chunks);
+        free(workers);
+        return false;
+    }
+    for (long i = 0; i < chunk_count; ++i) chunks[i].puzzles = -1;
+
+    int started = 0;
+    for (; started < threads; ++started) {
+        PuzzleWorker *worker = &workers[started];
+        worker->board.passes = options->passes;
+        worker->board.selection = options->selection;
+        worker->board.ordering = options->ordering;
+        worker->file = file;
+        worker->chunks = chunks;
+        worker->chunk_count = chunk_count;
+        worker->first_chunk = started;
+        worker->stride = threads;
+        worker->seed = options->seed;
+        worker->cache = options->cache;
+        worker->race_steps = options->race_steps;
+        worker->engine = options->engine;
+        worker->racers = racers;
+
+        if (pthread_create(&worker->thread, NULL, run_puzzle_worker, worker) != 0) break;
+    }
+
+    // Drain the chunks in the order they're in the file.
+    // If a thread failed to start, let the others finish by consuming
+    // whatever they still produce, without passing it on.
+    for (long i = 0; i < chunk_count; ++i) {
+        int worker = (int) (i % threads);
+        if (worker >= started) continue;
+        drain_chunk(&workers[worker], &chunks[i], started == threads ? callback : NULL, user_data);
+    }
+
+    for (int i = 0; i < started; ++i) {
+        pthread_join(workers[i].thread, NULL);
+        add_stats(stats, &workers[i].stats);
+    }
+
+    free(workers);
+    free(chunks);
+    return started == threads;
+}
@@ -0,0 +1,70 @@
+#ifndef PUZZLES_H
+#define PUZZLES_H
+
+#include <stddef.h>
+#include "generator.h"
+
+// Values are written as '1'-'9', and then 'A'-'P' on bigger boards,
+// so every tile of a board takes a single character.
+static inline char get_value_char(int value) {
+    return (char) (value < 9 ? '1' + value : 'A' + value - 9);
+}
+
+// The value of a character, or -1 if it isn't one.
+static inline int get_char_value(char c) {
+    int value = c >= '1' && c <= '9' ? c - '1' : c >= 'A' && c <= 'Z' ? c - 'A' + 9 : -1;
+    return value < TILE_STATES ? value : -1;
+}
+
+// Read a puzzle written as BOARD_SIZE characters, a value
+// (see get_value_char) for each given and '0' or '.' for every empty tile
+// (see EMPTY_TILE). Returns false if the text isn't a puzzle.
+bool read_puzzle(const char *text, size_t length, uint8_t puzzle[BOARD_SIZE]);
+
+// Set a board up with a puzzle (see read_puzzle)
+// by resetting it and collapsing every given.
+// Returns false if the text isn't a puzzle, or its givens contradict each other.
+bool load_puzzle(Board *board, const char *text, size_t length);
+
+// The same for a puzzle that has already been read.
+// Returns false if its givens contradict each other.
+bool set_puzzle(Board *board, const uint8_t puzzle[BOARD_SIZE]);
+
+// Turn a solved board into a puzzle with the same, unique solution,
+// by removing givens (in a random order) until none of them can be removed
+// without the puzzle getting another solution, and return the number left.
+// Whether another value leads to a solution is left to the ENGINE_
+// (see count_with_engine). The board is only used to work on,
+// and is left in an undefined state.
+int dig_puzzle(Board *board, int engine, DlxSolver *dlx, Random *random, Solution *puzzle);
+
+// A file of puzzles, one per line, mapped into memory.
+// The puzzles are read straight out of the mapping, never copied.
+typedef struct PuzzleFile {
+    const char *data;
+    size_t size;
+} PuzzleFile;
+
+// Returns false (with errno set) if the file can't be opened or mapped.
+bool open_puzzles(PuzzleFile *file, const char *path);
+void close_puzzles(PuzzleFile *file);
+
+// Solve every puzzle in the file, passing the solutions to the callback
+// in the same order as the puzzles. Blank lines are skipped.
+// The file is split into chunks that the worker threads take in turn,
+// and the random numbers for each chunk come from its own stream of the seed,
+// so the output doesn't depend on the number of threads.
+// With the options' race_steps, a single worker goes through the chunks,
+// racing the puzzles it can't solve quickly on every thread (see portfolio.h).
+// Which racer wins depends on timing, so a puzzle with more than one
+// solution can get any of them.
+// With a cache, a puzzle with more than one solution gets whichever one
+// was cached, which can depend on the timing of the workers.
+// The options' count, batched, dig and dedup are ignored.
+// Returns false if the workers could not be started.
+bool solve_puzzles(
+    const PuzzleFile *file, const GeneratorOptions *options,
+    SolutionCallback callback, void *user_data, GeneratorStats *stats
+);
+
+#endif // PUZZLES_H
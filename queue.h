@@ -0,0 +1,72 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+// sched_yield is POSIX, so whatever includes this has to define
+// _POSIX_C_SOURCE before its first include.
+#include <sched.h>
+#include <stddef.h>
+#include "generator.h"
+
+// The number of boards each worker can have waiting to be written.
+// This has to be a power of two so the indices can wrap with a mask.
+#define QUEUE_CAPACITY (1024)
+
+// Keeps the producer and consumer indices on separate cache lines.
+#define CACHE_LINE_SIZE (64)
+
+// A single-producer, single-consumer ring buffer of solutions.
+// Each worker owns one, so pushing never contends with other workers,
+// and the only synchronization is an acquire/release pair per board.
+typedef struct SolutionQueue {
+    // Written by the worker, read by the consumer.
+    size_t head;
+    char head_padding[CACHE_LINE_SIZE - sizeof(size_t)];
+
+    // Written by the consumer, read by the worker.
+    size_t tail;
+    char tail_padding[CACHE_LINE_SIZE - sizeof(size_t)];
+
+    Solution slots[QUEUE_CAPACITY];
+} SolutionQueue;
+
+// Get the next free slot in the queue to write a solution to.
+static inline Solution *reserve_solution(SolutionQueue *queue) {
+    size_t head = queue->head;
+
+    // Wait for the consumer if the queue is full.
+    while (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) == QUEUE_CAPACITY) {
+        sched_yield();
+    }
+
+    return &queue->slots[head & (QUEUE_CAPACITY - 1)];
+}
+
+static inline void push_solution(SolutionQueue *queue) {
+    // Publish the solution only after it has been fully written.
+    __atomic_store_n(&queue->head, queue->head + 1, __ATOMIC_RELEASE);
+}
+
+static inline const Solution *peek_solution(SolutionQueue *queue) {
+    size_t tail = queue->tail;
+
+    // Wait for the worker if the queue is empty.
+    while (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail) {
+        sched_yield();
+    }
+
+    return &queue->slots[tail & (QUEUE_CAPACITY - 1)];
+}
+
+// Get the oldest solution in the queue, or NULL if it's empty.
+static inline const Solution *try_peek_solution(SolutionQueue *queue) {
+    size_t tail = queue->tail;
+    if (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail) return NULL;
+    return &queue->slots[tail & (QUEUE_CAPACITY - 1)];
+}
+
+static inline void pop_solution(SolutionQueue *queue) {
+    // Hand the slot back to the worker once the consumer is done with it.
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+#endif // QUEUE_H
@@ -1,267 +1,178 @@
-#include <math.h>
 #include <time.h>
 #include "raylib.h"
+#include "dlx.h"
+#include "wfc.h"
 
-// Sudoku tiles have 9 possible states.
-#define TILE_STATES (9)
-
-#define BOARD_WIDTH (9)
-#define BOARD_SIZE (BOARD_WIDTH * BOARD_WIDTH)
 #define BOARD_PADDING (16)
 
 #define TILE_SIZE (128)
 #define TILE_CENTER (TILE_SIZE / 2)
-#define BOX_SIZE (TILE_SIZE / 3)
+#define BOX_SIZE (TILE_SIZE / BOX_WIDTH)
+#define SUBTILE_FONT_SIZE (96 / BOX_WIDTH)
+#define VALUE_FONT_SIZE (48)
 
 #define BOARD_TEXTURE_SIZE (BOARD_WIDTH * TILE_SIZE + BOARD_PADDING * 2)
 
 #define SCREEN_WIDTH (800)
 #define SCREEN_HEIGHT (800)
 
+// A solve only gets this much of each frame (in seconds), so a hard one
+// is spread over as many frames as it takes instead of freezing the window.
+// The clock is checked every SOLVE_STEPS steps.
+#define SOLVE_BUDGET (0.004)
+#define SOLVE_STEPS (32)
+
 // The factor by which the board texture is scaled to fit the window.
 // The board texture is constant, but the window is resizable.
 static float screen_scale = SCREEN_WIDTH / (float) BOARD_TEXTURE_SIZE;
 
-// The tiles are each stored as an integer,
-// with the first 9 bits representing its superpositions.
-// If a bit is set, the tile is allowed to be that number.
-static int tiles[BOARD_SIZE] = { 0 };
-
-// A place to store the previous state of the tiles.
-// TODO: A real undo system that can go back multiple steps.
-static int last_tiles[BOARD_SIZE] = { 0 };
-
-// Reset all tiles to be a superposition of 1-9.
-void reset_tiles(void) {
-    // 0x1FF sets the first 9 bits to 1.
-    // This indicates that the tile can be any number.
-    for (int i = 0; i < BOARD_SIZE; ++i) tiles[i] = 0x1FF;
-}
-
-// Undo the last change to the tiles.
-void undo_tiles(void) {
-    // Copy the last state of the tiles back to the current state.
-    for (int i = 0; i < BOARD_SIZE; ++i) tiles[i] = last_tiles[i];
-}
-
-// Get a pointer to a tile at a given position.
-int *get_tile(int x, int y) {
-    // The tiles are stored in a 1D array.
-    // Multiplying by BOARD_WIDTH gets the row,
-    // and adding the column gets the 1D index of the tile.
-    return &tiles[y * BOARD_WIDTH + x];
-}
-
-// Check if a specific bit in a tile is set.
-bool is_set(int x, int y, int bit) {
-    return *get_tile(x, y) & (1 << bit);
-}
-
-// The entropy of a tile is the number of superpositions it has.
-// This is the number of bits set in the tile's integer value.
-// This function doesnt take x and y because
-// it makes iterating through the tiles slightly easier (see solve_board).
-int get_tile_entropy(int i) {
-    int x = i % BOARD_WIDTH;
-    int y = i / BOARD_WIDTH;
-    int entropy = 0;
-    for (int i = 0; i < TILE_STATES; ++i) {
-        entropy += is_set(x, y, i);
+// The text of every value, in the size of a collapsed tile and in the size
+// of a superposition, drawn once into a texture at the start.
+// Drawing a value is then just drawing part of the texture (which raylib
+// batches with the rest of them), with no formatting or text layout.
+typedef struct GlyphAtlas {
+    Texture2D texture;
+    Rectangle values[TILE_STATES];
+    Rectangle superpositions[TILE_STATES];
+} GlyphAtlas;
+
+static GlyphAtlas atlas;
+
+// The values go side by side, the big ones along the top
+// and the superpositions under them.
+static void load_glyph_atlas(void) {
+    int big_width = 0;
+    int small_width = 0;
+    for (int value = 0; value < TILE_STATES; ++value) {
+        int big = MeasureText(TextFormat("%d", value + 1), VALUE_FONT_SIZE);
+        int small = MeasureText(TextFormat(" %d", value + 1), SUBTILE_FONT_SIZE);
+        atlas.values[value] = (Rectangle) { big_width, 0, big, VALUE_FONT_SIZE };
+        atlas.superpositions[value] = (Rectangle) { small_width, VALUE_FONT_SIZE, small, SUBTILE_FONT_SIZE };
+        big_width += big;
+        small_width += small;
     }
-    return entropy;
-}
-
-int get_board_entropy(void) {
-    int entropy = 0;
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        entropy += get_tile_entropy(i);
+    int width = big_width > small_width ? big_width : small_width;
+
+    Image image = GenImageColor(width, VALUE_FONT_SIZE + SUBTILE_FONT_SIZE, BLANK);
+    for (int value = 0; value < TILE_STATES; ++value) {
+        Rectangle big = atlas.values[value];
+        Rectangle small = atlas.superpositions[value];
+        ImageDrawText(&image, TextFormat("%d", value + 1), big.x, big.y, VALUE_FONT_SIZE, BLACK);
+        ImageDrawText(&image, TextFormat(" %d", value + 1), small.x, small.y, SUBTILE_FONT_SIZE, GRAY);
     }
-    return entropy;
+    atlas.texture = LoadTextureFromImage(image);
+    UnloadImage(image);
 }
 
-// Check if a tile's superpositions only contain one value.
-bool is_collapsed(int x, int y) {
-    return get_tile_entropy(x + y * BOARD_WIDTH) == 1;
+// Draw a value (or superposition) from the atlas with its top left corner at x, y.
+static void draw_glyph(Rectangle glyph, int x, int y) {
+    DrawTextureRec(atlas.texture, glyph, (Vector2) { x, y }, WHITE);
 }
 
-// Get the value of a collapsed tile.
-int get_collapsed_value(int x, int y) {
-    int value = *get_tile(x, y);
-    // This mask is the first 9 bits set to 1.
-    // This is used because the integer value can be larger than 9 bits
-    // and if it is, anything above the first 9 bits should be ignored.
-    int mask = (1 << TILE_STATES) - 1;
-
-    // log2 gets the index of the set bit
-    // because a binary number with only one bit set
-    // is some power of 2.
-    return (int) log2(value & mask);
-}
-
-// Forwards declaration for recursion.
-void constrain_peers(int x, int y, int value);
-
-// Remove a superposition from a tile
-// by unsetting the bit at the index of the value.
-void constrain_tile(int x, int y, int value) {
-    *get_tile(x, y) &= ~(1 << value);
-
-    // If the tile was just collapsed because of this constraint,
-    // propagate the constraint to its peers.
-    if (is_collapsed(x, y)) constrain_peers(x, y, get_collapsed_value(x, y));
-}
-
-// Constrain a tile's peers by removing a superposition.
-void constrain_peers(int x, int y, int value) {
-    // Constrain the row and column that the tile belongs to.
-    for (int i = 0; i < BOARD_WIDTH; ++i) {
-        // Skip the tile that set the constraint.
-        if (i == x || i == y) continue;
-
-        // Skip tiles that are already collapsed.
-        if (!is_collapsed(i, y)) constrain_tile(i, y, value);
-        if (!is_collapsed(x, i)) constrain_tile(x, i, value);
-    }
-
-    // Successively dividing and multiplying by 3,
-    // effectively rounds down to the nearest multiple of 3.
-    // This gives us the index of the top-left tile in the box.
-    int box_x = x / 3 * 3;
-    int box_y = y / 3 * 3;
-
-    // Constrain the 3x3 box that the tile belongs to.
-    for (int i = box_y; i < box_y + 3; ++i) {
-        for (int j = box_x; j < box_x + 3; ++j) {
-            // Skip the tile that set the constraint.
-            if (i == y && j == x) continue;
-
-            // Skip tiles that are already collapsed.
-            if (!is_collapsed(j, i)) constrain_tile(j, i, value);
-            
-        }
-    }
-}
-
-// Collapse a tile to a single value.
-void collapse_tile(int x, int y, int value) {
-    // Store the last board state for undo.
-    for (int i = 0; i < BOARD_SIZE; ++i) last_tiles[i] = tiles[i];
-
-    // Set the tile to only contain the collapsed value.
-    *get_tile(x, y) = 1 << value;
-
-    // Constrain the superpositions of the tile's in the same
-    // row, column, and 3x3 box to not contain the collapsed value.
-    constrain_peers(x, y, value);
+// The board texture keeps whatever was drawn to it, so it doubles as a cache
+// of every tile, and only the tiles that changed are drawn again.
+// A tile changed if its superpositions aren't the ones it was last drawn
+// with, which catches every change the solver makes (collapses, constraints,
+// undos and resets alike) without it having to keep track of them.
+// When the mouse moves to another superposition, the tile it was over is
+// drawn again to clear the highlight, and the one it's over to draw it.
+static Tile drawn_tiles[BOARD_SIZE];
+static bool board_drawn = false;
+
+// The superposition (or subtile) under the mouse, which is what a click
+// collapses its tile to. The tile is -1 if the mouse isn't over the board.
+typedef struct Pick {
+    int tile;
+    int bit;
+} Pick;
+
+static Pick drawn_pick = { -1, -1 };
+
+// Find the subtile under the mouse by dividing its position by the tile
+// and subtile sizes, the inverse of where draw_tile puts them.
+static Pick get_mouse_pick(void) {
+    static const Pick none = { -1, -1 };
+
+    // Get the mouse position, scaled according to the screen scale.
+    Vector2 mouse_pos = GetMousePosition();
+    float board_x = mouse_pos.x / screen_scale - BOARD_PADDING;
+    float board_y = mouse_pos.y / screen_scale - BOARD_PADDING;
+    if (board_x < 0 || board_y < 0) return none;
+
+    int x = (int) board_x / TILE_SIZE;
+    int y = (int) board_y / TILE_SIZE;
+    if (x >= BOARD_WIDTH || y >= BOARD_WIDTH) return none;
+
+    // The subtiles don't fill the whole tile when BOX_SIZE is rounded down.
+    int column = (int) board_x % TILE_SIZE / BOX_SIZE;
+    int row = (int) board_y % TILE_SIZE / BOX_SIZE;
+    if (column >= BOX_WIDTH || row >= BOX_WIDTH) return none;
+
+    return (Pick) { y * BOARD_WIDTH + x, column * BOX_WIDTH + row };
 }
 
-// Solve the board by recusively collapsing the tile with the least entropy.
-// Entropy, in this case, is the number of superpositions a tile has.
-void solve_board(void) {
-    // If the board entropy is the same as the size of the board,
-    // every tile has been collapsed to a single value, and the board is solved.
-    if (get_board_entropy() == BOARD_SIZE) return;
-
-    int sorted_tiles[BOARD_SIZE];
-    for (int i = 0; i < BOARD_SIZE; ++i) sorted_tiles[i] = i;
-
-    // Sort the tiles by entropy.
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        for (int j = i + 1; j < BOARD_SIZE; ++j) {
-            int a = get_tile_entropy(sorted_tiles[i]);
-            int b = get_tile_entropy(sorted_tiles[j]);
-            if (a <= b) continue;
-
-            int temp = sorted_tiles[i];
-            sorted_tiles[i] = sorted_tiles[j];
-            sorted_tiles[j] = temp;
-        }
-    }
-
-    // Find the first tile in the sorted array that is not collapsed.
-    for (int i = 0; i < BOARD_SIZE; ++i) {
-        int tile = sorted_tiles[i];
-        int x = tile % BOARD_WIDTH;
-        int y = tile / BOARD_WIDTH;
-        if (is_collapsed(x, y)) continue;
-
-        // Find a random value that is in the tile's superpositions.
-        int value = GetRandomValue(0, TILE_STATES - 1);
-        while (!is_set(x, y, value)) {
-            value = (value + 1) % TILE_STATES;
-        }
-
-        // Collapse the tile to the random value.
-        collapse_tile(x, y, value);
-    }
-
-    // Recursively solve the rest of the board.
-    solve_board();
-}
-
-// Draw a tile at a given board position.
-void draw_tile(int x, int y) {
+// Draw a tile at a given board position,
+// highlighting a superposition (if it isn't -1).
+void draw_tile(Board *board, int x, int y, int hovered_bit) {
     int tile_x = x * TILE_SIZE + BOARD_PADDING;
     int tile_y = y * TILE_SIZE + BOARD_PADDING;
 
+    // Clear whatever the tile was drawn as before.
+    DrawRectangle(tile_x, tile_y, TILE_SIZE, TILE_SIZE, RAYWHITE);
+
     // Draw the tile's border.
     DrawRectangleLines(tile_x, tile_y, TILE_SIZE, TILE_SIZE, BLACK);
 
     // If the tile is collapsed, draw the collapsed value at the center.
-    if (is_collapsed(x, y)) {
+    if (is_collapsed(board, x, y)) {
         int x_center = tile_x + TILE_CENTER;
         int y_center = tile_y + TILE_CENTER;
-        const char *text = TextFormat("%d", get_collapsed_value(x, y) + 1);
-        int text_width = MeasureText(text, 48);
-        DrawText(text, x_center - text_width / 2, y_center - 24, 48, BLACK);
+        Rectangle glyph = atlas.values[get_collapsed_value(board, x, y)];
+        draw_glyph(glyph, x_center - (int) glyph.width / 2, y_center - VALUE_FONT_SIZE / 2);
         return;
     }
 
     // If the tile is not collapsed, draw the remaining superpositions.
     for (int bit = 0; bit < TILE_STATES; ++bit) {
         // Do not draw the superposition if it is not set.
-        if (!is_set(x, y, bit)) continue;
+        if (!is_set(board, x, y, bit)) continue;
 
-        int subtile_x = tile_x + bit / 3 * BOX_SIZE;
-        int subtile_y = tile_y + bit % 3 * BOX_SIZE;
-
-        Rectangle subtile_rect = {
-            subtile_x, subtile_y,
-            BOX_SIZE, BOX_SIZE
-        };
-
-        // Get the mouse position, scaled according to the screen scale.
-        Vector2 mouse_pos = GetMousePosition();
-        mouse_pos.x /= screen_scale;
-        mouse_pos.y /= screen_scale;
+        int subtile_x = tile_x + bit / BOX_WIDTH * BOX_SIZE;
+        int subtile_y = tile_y + bit % BOX_WIDTH * BOX_SIZE;
 
         // Highlight the subtile if the mouse is hovering over it.
-        bool is_hovered = CheckCollisionPointRec(mouse_pos, subtile_rect);
-        if (is_hovered) DrawRectangleRec(subtile_rect, LIGHTGRAY);
+        if (bit == hovered_bit) DrawRectangle(subtile_x, subtile_y, BOX_SIZE, BOX_SIZE, LIGHTGRAY);
 
         // Draw the number of the superposition at the center of the subtile.
-        const char *text = TextFormat(" %d", bit + 1);
-        DrawText(text, subtile_x, subtile_y + 8, 32, GRAY);
-
-        // If the user clicks on a subtile,
-        // collapse the tile to the value of the subtile.
-        // NOTE: I would like if this were handled in the main loop instead,
-        // but I already had the tile positions available here.
-        if (is_hovered && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            collapse_tile(x, y, bit);
-        }
+        draw_glyph(atlas.superpositions[bit], subtile_x, subtile_y + BOX_SIZE / 5);
     }
 }
 
-// Draw the entire board.
-void draw_board(void) {
-    // Draw all tiles on the board.
+// Draw the tiles of the board that changed since the last frame,
+// with the superposition under the mouse highlighted.
+void draw_board(Board *board, Pick pick) {
+    // The first frame has to draw everything.
+    if (!board_drawn) ClearBackground(RAYWHITE);
+
+    bool moved = pick.tile != drawn_pick.tile || pick.bit != drawn_pick.bit;
+    bool drawn = false;
     for (int iter = 0; iter < BOARD_SIZE; ++iter) {
-        draw_tile(iter % BOARD_WIDTH, iter / BOARD_WIDTH);
+        bool changed = !board_drawn || board->tiles[iter] != drawn_tiles[iter];
+        bool hovered = moved && (iter == pick.tile || iter == drawn_pick.tile);
+        if (!changed && !hovered) continue;
+
+        drawn_tiles[iter] = board->tiles[iter];
+        draw_tile(board, iter % BOARD_WIDTH, iter / BOARD_WIDTH, iter == pick.tile ? pick.bit : -1);
+        drawn = true;
     }
+    board_drawn = true;
+    drawn_pick = pick;
 
-    // Draw thicker lines to separate the 3x3 boxes.
-    for (int i = 0; i <= BOARD_WIDTH; i += 3) {
+    // Drawing a tile clears the box lines along its edges.
+    if (!drawn) return;
+
+    // Draw thicker lines to separate the boxes.
+    for (int i = 0; i <= BOARD_WIDTH; i += BOX_WIDTH) {
         Rectangle rect = {
             BOARD_PADDING, BOARD_PADDING + i * TILE_SIZE,
             BOARD_WIDTH * TILE_SIZE, 6
@@ -277,7 +188,8 @@ void draw_board(void) {
 }
 
 int main(void) {
-    SetRandomSeed(time(0));
+    Random random;
+    seed_random(&random, time(0), 0);
 
     int width = SCREEN_WIDTH;
     int height = SCREEN_HEIGHT;
@@ -287,11 +199,24 @@ int main(void) {
     SetTargetFPS(60);
 
     // Initialize the tiles to potentially be any number.
-    reset_tiles();
+    Board board = { 0 };
+    reset_tiles(&board);
+
+    // The solve in progress, if there is one. When animating,
+    // it only takes a step a frame, so every collapse can be seen.
+    SolveState solve;
+    bool solving = false;
+    bool animating = false;
+
+    // Exact cover solves the board in one go, and is too big for the stack.
+    static DlxSolver dlx;
+
+    // The font is only there once the window is.
+    load_glyph_atlas();
 
     // Create a render texture to draw the board to.
     int board_size = BOARD_TEXTURE_SIZE;
-    RenderTexture2D board = LoadRenderTexture(board_size, board_size);
+    RenderTexture2D board_texture = LoadRenderTexture(board_size, board_size);
 
     // The source rectangle is the size of the board texture.
     // The height component is negative because OpenGL's coordinate system
@@ -342,12 +267,25 @@ int main(void) {
             destination = (Rectangle) { 0, 0, width, height };
         }
 
+        // The mouse is only looked at once a frame, for drawing and clicking.
+        Pick pick = get_mouse_pick();
+
+        // Take this frame's steps of the solve before drawing them.
+        if (solving) {
+            if (animating) {
+                continue_solve(&board, &solve, &random, 1);
+            } else {
+                double deadline = GetTime() + SOLVE_BUDGET;
+                while (continue_solve(&board, &solve, &random, SOLVE_STEPS) == SOLVE_RUNNING && GetTime() < deadline) {}
+            }
+            solving = solve.status == SOLVE_RUNNING;
+        }
+
         // Start drawing to the render texture.
-        BeginTextureMode(board);
+        BeginTextureMode(board_texture);
             // Draw the board to the render texture.
             BeginMode2D(board_camera);
-                ClearBackground(RAYWHITE);
-                draw_board();
+                draw_board(&board, pick);
             EndMode2D();
         EndTextureMode();
 
@@ -357,7 +295,7 @@ int main(void) {
             // Draw the render texture to the window.
             BeginMode2D(screen_camera);
                 DrawTexturePro(
-                    board.texture,
+                    board_texture.texture,
                     source, destination,
                     origin, 0,
                     WHITE
@@ -366,16 +304,48 @@ int main(void) {
         EndDrawing();
 
         // Handle user input.
-        if (IsKeyPressed(KEY_Z)) undo_tiles();
-        if (IsKeyPressed(KEY_R)) reset_tiles();
-        if (IsKeyPressed(KEY_S)) {
-            if (get_board_entropy() == BOARD_SIZE) reset_tiles();
-            solve_board();
+        // Any change to the board stops the solve, which can't be resumed
+        // once the board has changed under it.
+        // Clicking a superposition of a tile collapses the tile to it.
+        if (pick.tile >= 0 && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            int x = pick.tile % BOARD_WIDTH;
+            int y = pick.tile / BOARD_WIDTH;
+            if (!is_collapsed(&board, x, y) && is_set(&board, x, y, pick.bit)) {
+                solving = false;
+                collapse_tile(&board, x, y, pick.bit);
+            }
+        }
+        if (IsKeyPressed(KEY_Z)) {
+            solving = false;
+            undo_tiles(&board);
+        }
+        if (IsKeyPressed(KEY_R)) {
+            solving = false;
+            reset_tiles(&board);
+        }
+
+        // S solves as fast as the frames allow, and A animates the solve.
+        // Either one switches a solve that's already running to its speed.
+        bool animate = IsKeyPressed(KEY_A);
+        if (IsKeyPressed(KEY_S) || animate) {
+            if (!solving) {
+                if (get_board_entropy(&board) == BOARD_SIZE) reset_tiles(&board);
+                solving = start_solve(&board, &solve) == SOLVE_RUNNING;
+            }
+            animating = animate;
+        }
+
+        // D solves the board with the other engine (see dlx.h), all at once.
+        if (IsKeyPressed(KEY_D)) {
+            solving = false;
+            if (get_board_entropy(&board) == BOARD_SIZE) reset_tiles(&board);
+            dlx_solve_board(&dlx, &board, &random);
         }
     }
 
-    // Release the render texture and close the window.
-    UnloadRenderTexture(board);
+    // Release the textures and close the window.
+    UnloadRenderTexture(board_texture);
+    UnloadTexture(atlas.texture);
     CloseWindow();
 
     return 0;
@@ -0,0 +1,389 @@
+#include <stdlib.h>
+#include <string.h>
+#include "symmetry.h"
+
+void apply_transform(const Transform *transform, const uint8_t values[BOARD_SIZE], uint8_t out[BOARD_SIZE]) {
+    for (int y = 0; y < BOARD_WIDTH; ++y) {
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            int row = transform->rows[y];
+            int column = transform->columns[x];
+            uint8_t value = transform->transposed
+                ? values[column * BOARD_WIDTH + row]
+                : values[row * BOARD_WIDTH + column];
+            out[y * BOARD_WIDTH + x] = value == EMPTY_TILE ? EMPTY_TILE : transform->labels[value];
+        }
+    }
+}
+
+void undo_transform(const Transform *transform, const uint8_t values[BOARD_SIZE], uint8_t out[BOARD_SIZE]) {
+    uint8_t values_of[TILE_STATES];
+    for (int value = 0; value < TILE_STATES; ++value) values_of[transform->labels[value]] = (uint8_t) value;
+
+    for (int y = 0; y < BOARD_WIDTH; ++y) {
+        for (int x = 0; x < BOARD_WIDTH; ++x) {
+            int row = transform->rows[y];
+            int column = transform->columns[x];
+            int i = transform->transposed ? column * BOARD_WIDTH + row : row * BOARD_WIDTH + column;
+            uint8_t label = values[y * BOARD_WIDTH + x];
+            out[i] = label == EMPTY_TILE ? EMPTY_TILE : values_of[label];
+        }
+    }
+}
+
+// The canonical form is the equivalent board that compares the smallest
+// box by box (and in reading order within a box), which is found by picking
+// the rows and columns of the result as the tiles being compared need them,
+// and keeping only the choices that make the tile the smallest.
+// Values are labeled in the order they first appear, which is the only
+// labeling that can be the smallest.
+//
+// Comparing by boxes instead of by rows matters for solved boards:
+// every arrangement of the first row (or box) labels to the same values,
+// but the first box is done after just three rows and three columns,
+// and the box next to it tells most of the arrangements apart right away.
+//
+// Tiles are compared as codes, the label + 1 for a collapsed tile and
+// EMPTY_CODE for an empty one, so the givens come first.
+//
+// Ties are what make it slow: an empty tile is empty whatever is picked for
+// it, so every way of picking its row and column has to be tried. Once every
+// given has been compared, though, the rest of the codes are all EMPTY_CODE,
+// and any way of picking the rest of the lines gives the same codes,
+// so only one is tried. Before that, two lines without any givens
+// that are both free to pick are just as interchangeable, if they're in
+// the same band (or stack), or in two bands without any givens at all.
+// Without those an empty board takes about a second.
+#define EMPTY_CODE (TILE_STATES + 1)
+
+typedef struct Search {
+    // The board (transposed or not) with every value as value + 1,
+    // and 0 for an empty tile.
+    uint8_t grid[BOARD_SIZE];
+    bool transposed;
+
+    // The rows and columns of the board picked for the result so far (-1 if
+    // not picked yet), and the labels of the values (by value + 1, 0 if not
+    // labeled yet).
+    int8_t rows[BOARD_WIDTH];
+    int8_t columns[BOARD_WIDTH];
+    unsigned int used_rows;
+    unsigned int used_columns;
+    uint8_t labels[TILE_STATES + 1];
+    int next_label;
+
+    // The codes of the tiles compared so far, the number of givens
+    // among them, and the number of givens on the board.
+    uint8_t codes[BOARD_SIZE];
+    int placed;
+    int givens;
+
+    // The rows and columns of the board with any givens in them.
+    unsigned int given_rows;
+    unsigned int given_columns;
+
+    // The smallest codes so far, how they were found, and how many times
+    // they've been replaced.
+    bool found;
+    uint8_t best[BOARD_SIZE];
+    Transform transform;
+    long records;
+} Search;
+
+// The tile of the result that's compared at a position.
+static int get_compared_tile(int position) {
+    int box = position / BOARD_WIDTH;
+    int k = position % BOARD_WIDTH;
+    int y = box / BOX_WIDTH * BOX_WIDTH + k / BOX_WIDTH;
+    int x = box % BOX_WIDTH * BOX_WIDTH + k % BOX_WIDTH;
+    return y * BOARD_WIDTH + x;
+}
+
+// Get the lines of the board that can be picked for line position of the
+// result, if it isn't picked yet. The first line of a band (or stack) can be
+// any line of one that isn't used yet, the others have to come from the same one.
+static int get_free_lines(int position, const int8_t picked[BOARD_WIDTH], unsigned int used, uint8_t lines[BOARD_WIDTH]) {
+    if (picked[position] >= 0) {
+        lines[0] = (uint8_t) picked[position];
+        return 1;
+    }
+
+    const unsigned int band_lines = (1u << BOX_WIDTH) - 1;
+    unsigned int free = 0;
+    if (position % BOX_WIDTH) {
+        free = (band_lines << (picked[position - 1] / BOX_WIDTH * BOX_WIDTH)) & ~used;
+    } else {
+        for (int band = 0; band < BOX_WIDTH; ++band) {
+            unsigned int lines = band_lines << (band * BOX_WIDTH);
+            if (!(used & lines)) free |= lines;
+        }
+    }
+
+    int count = 0;
+    for (; free; free &= free - 1) lines[count++] = (uint8_t) lowest_bit(free);
+    return count;
+}
+
+// Whether a line without givens can be skipped, because one of the free
+// lines before it is interchangeable with it.
+static bool is_interchangeable(const uint8_t lines[BOARD_WIDTH], int index, unsigned int given_lines) {
+    const unsigned int band_lines = (1u << BOX_WIDTH) - 1;
+    int line = lines[index];
+    if (given_lines & (1u << line)) return false;
+
+    for (int k = 0; k < index; ++k) {
+        int other = lines[k];
+        if (given_lines & (1u << other)) continue;
+        if (other / BOX_WIDTH == line / BOX_WIDTH) return true;
+        unsigned int bands = band_lines << (other / BOX_WIDTH * BOX_WIDTH) | band_lines << (line / BOX_WIDTH * BOX_WIDTH);
+        if (!(given_lines & bands)) return true;
+    }
+    return false;
+}
+
+static int get_code(const Search *search, int row, int column) {
+    int value = search->grid[row * BOARD_WIDTH + column];
+    if (!value) return EMPTY_CODE;
+    return search->labels[value] ? search->labels[value] : search->next_label + 1;
+}
+
+static void record_best(Search *search) {
+    memcpy(search->best, search->codes, BOARD_SIZE);
+    search->found = true;
+    ++search->records;
+
+    Transform *transform = &search->transform;
+    transform->transposed = search->transposed;
+    for (int k = 0; k < BOARD_WIDTH; ++k) {
+        transform->rows[k] = (uint8_t) search->rows[k];
+        transform->columns[k] = (uint8_t) search->columns[k];
+    }
+
+    // Values that never appear still need labels, for the transform
+    // to work on the solution of a puzzle.
+    int next_label = search->next_label;
+    for (int value = 0; value < TILE_STATES; ++value) {
+        int label = search->labels[value + 1] ? search->labels[value + 1] : ++next_label;
+        transform->labels[value] = (uint8_t) (label - 1);
+    }
+}
+
+static void search_tiles(Search *search, int position, bool less);
+
+// Try every way of picking the row or column (or both) a tile needs
+// that makes its code the smallest.
+static void branch_tiles(Search *search, int position, bool less) {
+    int tile = get_compared_tile(position);
+    int y = tile / BOARD_WIDTH;
+    int x = tile % BOARD_WIDTH;
+    uint8_t rows[BOARD_WIDTH], columns[BOARD_WIDTH];
+    int row_count = get_free_lines(y, search->rows, search->used_rows, rows);
+    int column_count = get_free_lines(x, search->columns, search->used_columns, columns);
+
+    uint8_t codes[BOARD_WIDTH][BOARD_WIDTH];
+    int smallest = EMPTY_CODE;
+    for (int r = 0; r < row_count; ++r) {
+        for (int c = 0; c < column_count; ++c) {
+            codes[r][c] = (uint8_t) get_code(search, rows[r], columns[c]);
+            if (codes[r][c] < smallest) smallest = codes[r][c];
+        }
+    }
+    if (!less && smallest > search->best[position]) return;
+
+    bool pick_row = search->rows[y] < 0;
+    bool pick_column = search->columns[x] < 0;
+    for (int r = 0; r < row_count; ++r) {
+        if (pick_row && is_interchangeable(rows, r, search->given_rows)) continue;
+        for (int c = 0; c < column_count; ++c) {
+            if (codes[r][c] != smallest) continue;
+            if (pick_column && is_interchangeable(columns, c, search->given_columns)) continue;
+
+            if (pick_row) {
+                search->rows[y] = (int8_t) rows[r];
+                search->used_rows |= 1u << rows[r];
+            }
+            if (pick_column) {
+                search->columns[x] = (int8_t) columns[c];
+                search->used_columns |= 1u << columns[c];
+            }
+
+            // If a better form was found further down, it starts
+            // with the same codes as this one up to the tile.
+            long records = search->records;
+            search_tiles(search, position, less);
+            if (search->records != records) less = false;
+
+            if (pick_column) {
+                search->columns[x] = -1;
+                search->used_columns &= ~(1u << columns[c]);
+            }
+            if (pick_row) {
+                search->rows[y] = -1;
+                search->used_rows &= ~(1u << rows[r]);
+            }
+        }
+    }
+}
+
+// Compare the tiles from a position on, for as long as their rows and
+// columns are already picked, labeling any new values on the way.
+// Returns the position of the first tile that needs a pick,
+// or -1 if the codes got bigger than the best.
+static int compare_picked(Search *search, int position, bool *less, uint8_t labeled[TILE_STATES], int *labeled_count) {
+    for (; position < BOARD_SIZE; ++position) {
+        int tile = get_compared_tile(position);
+        int row = search->rows[tile / BOARD_WIDTH];
+        int column = search->columns[tile % BOARD_WIDTH];
+        if (row < 0 || column < 0) break;
+
+        int code = get_code(search, row, column);
+        if (!*less) {
+            if (code > search->best[position]) return -1;
+            *less = code < search->best[position];
+        }
+
+        int value = search->grid[row * BOARD_WIDTH + column];
+        if (value && !search->labels[value]) {
+            search->labels[value] = (uint8_t) ++search->next_label;
+            labeled[(*labeled_count)++] = (uint8_t) value;
+        }
+        search->placed += value != 0;
+        search->codes[position] = (uint8_t) code;
+    }
+    return position;
+}
+
+// Pick the lines that aren't picked yet in order, each the first one free,
+// which are as good as any once only empty tiles are left to compare.
+static void pick_first_lines(int8_t picked[BOARD_WIDTH], unsigned int *used) {
+    uint8_t lines[BOARD_WIDTH];
+    for (int position = 0; position < BOARD_WIDTH; ++position) {
+        if (picked[position] >= 0) continue;
+        get_free_lines(position, picked, *used, lines);
+        picked[position] = (int8_t) lines[0];
+        *used |= 1u << lines[0];
+    }
+}
+
+// Record the best with only empty tiles left from a position on, leaving
+// the picks as they were. The best is always at most all EMPTY_CODE there,
+// so that's only smaller than it if the codes so far already are.
+static void record_empty_rest(Search *search, int position) {
+    int8_t rows[BOARD_WIDTH], columns[BOARD_WIDTH];
+    memcpy(rows, search->rows, sizeof(rows));
+    memcpy(columns, search->columns, sizeof(columns));
+    unsigned int used_rows = search->used_rows;
+    unsigned int used_columns = search->used_columns;
+
+    memset(search->codes + position, EMPTY_CODE, (size_t) (BOARD_SIZE - position));
+    pick_first_lines(search->rows, &search->used_rows);
+    pick_first_lines(search->columns, &search->used_columns);
+    record_best(search);
+
+    memcpy(search->rows, rows, sizeof(rows));
+    memcpy(search->columns, columns, sizeof(columns));
+    search->used_rows = used_rows;
+    search->used_columns = used_columns;
+}
+
+// Pick whatever the tile at a position needs, for every way to make its code
+// the smallest. less is whether the codes so far are already smaller than the best.
+static void search_tiles(Search *search, int position, bool less) {
+    uint8_t labeled[TILE_STATES];
+    int labeled_count = 0;
+    int placed = search->placed;
+    position = compare_picked(search, position, &less, labeled, &labeled_count);
+
+    if (position == BOARD_SIZE) {
+        if (less) record_best(search);
+    } else if (position >= 0 && search->placed == search->givens) {
+        if (less) record_empty_rest(search, position);
+    } else if (position >= 0) {
+        branch_tiles(search, position, less);
+    }
+
+    search->placed = placed;
+    search->next_label -= labeled_count;
+    while (labeled_count) search->labels[labeled[--labeled_count]] = 0;
+}
+
+void get_canonical_form(const uint8_t values[BOARD_SIZE], uint8_t canonical[BOARD_SIZE], Transform *transform) {
+    Search search;
+    memset(&search, 0, sizeof(search));
+    memset(search.rows, -1, sizeof(search.rows));
+    memset(search.columns, -1, sizeof(search.columns));
+
+    for (int transposed = 0; transposed < 2; ++transposed) {
+        search.transposed = transposed;
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            int tile = transposed ? i % BOARD_WIDTH * BOARD_WIDTH + i / BOARD_WIDTH : i;
+            search.grid[i] = values[tile] == EMPTY_TILE ? 0 : (uint8_t) (values[tile] + 1);
+        }
+        search.givens = 0;
+        search.given_rows = 0;
+        search.given_columns = 0;
+        for (int i = 0; i < BOARD_SIZE; ++i) {
+            if (!search.grid[i]) continue;
+            ++search.givens;
+            search.given_rows |= 1u << (i / BOARD_WIDTH);
+            search.given_columns |= 1u << (i % BOARD_WIDTH);
+        }
+        search_tiles(&search, 0, !search.found);
+    }
+
+    apply_transform(&search.transform, values, canonical);
+    if (transform) *transform = search.transform;
+}
+
+// FNV-1a, which is plenty for telling boards apart.
+uint64_t hash_values(const uint8_t values[BOARD_SIZE]) {
+    uint64_t hash = 0xCBF29CE484222325u;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        hash ^= values[i];
+        hash *= 0x100000001B3u;
+    }
+    return hash ? hash : 1;
+}
+
+// Keep the table at most half full, so probes stay short.
+static bool grow_hash_set(HashSet *set) {
+    size_t capacity = set->capacity ? set->capacity * 2 : 1024;
+    uint64_t *slots = calloc(capacity, sizeof(uint64_t));
+    if (!slots) return false;
+
+    for (size_t i = 0; i < set->capacity; ++i) {
+        uint64_t hash = set->slots[i];
+        if (!hash) continue;
+
+        size_t slot = hash & (capacity - 1);
+        while (slots[slot]) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = hash;
+    }
+
+    free(set->slots);
+    set->slots = slots;
+    set->capacity = capacity;
+    return true;
+}
+
+bool add_hash(HashSet *set, uint64_t hash, bool *added) {
+    if ((set->count + 1) * 2 > set->capacity && !grow_hash_set(set)) return false;
+
+    size_t slot = hash & (set->capacity - 1);
+    while (set->slots[slot]) {
+        if (set->slots[slot] == hash) {
+            *added = false;
+            return true;
+        }
+        slot = (slot + 1) & (set->capacity - 1);
+    }
+
+    set->slots[slot] = hash;
+    ++set->count;
+    *added = true;
+    return true;
+}
+
+void free_hash_set(HashSet *set) {
+    free(set->slots);
+    *set = (HashSet) { 0 };
+}
@@ -0,0 +1,52 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "generator.h"
+
+// A symmetry of the board, which turns any solved board (or puzzle)
+// into an equivalent one: the rows and columns can be swapped,
+// the bands, the stacks, the rows within a band and the columns within
+// a stack can be reordered, and the values can be relabeled.
+typedef struct Transform {
+    // Whether the rows and columns are swapped before anything else.
+    bool transposed;
+
+    // Row y of the result is row rows[y] of the (transposed) board,
+    // column x is column columns[x], and value v becomes labels[v].
+    uint8_t rows[BOARD_WIDTH];
+    uint8_t columns[BOARD_WIDTH];
+    uint8_t labels[TILE_STATES];
+} Transform;
+
+// Apply a transform to the values of a board (or puzzle, see EMPTY_TILE),
+// or undo it, so undo_transform(t, apply_transform(t, values)) == values.
+void apply_transform(const Transform *transform, const uint8_t values[BOARD_SIZE], uint8_t out[BOARD_SIZE]);
+void undo_transform(const Transform *transform, const uint8_t values[BOARD_SIZE], uint8_t out[BOARD_SIZE]);
+
+// Get the canonical form of a board or puzzle: whichever of its equivalent
+// boards has the smallest values, compared box by box (in reading order
+// within a box), with empty tiles bigger than any value.
+// Two boards are equivalent exactly when their canonical forms are the same.
+// The transform that turns the values into the canonical form
+// is written to transform, if it isn't NULL.
+void get_canonical_form(const uint8_t values[BOARD_SIZE], uint8_t canonical[BOARD_SIZE], Transform *transform);
+
+// A 64-bit hash of the values of a board, never 0.
+// Hashing the canonical form gives the same hash to equivalent boards.
+uint64_t hash_values(const uint8_t values[BOARD_SIZE]);
+
+// A set of (non-zero) hashes, as an open addressed table that grows as needed.
+typedef struct HashSet {
+    uint64_t *slots;
+    size_t capacity;
+    size_t count;
+} HashSet;
+
+// Add a hash to the set, setting added to whether it wasn't in the set yet.
+// Returns false if the set had to grow and couldn't.
+bool add_hash(HashSet *set, uint64_t hash, bool *added);
+void free_hash_set(HashSet *set);
+
+#endif // SYMMETRY_H
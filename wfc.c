@@ -0,0 +1,809 @@
+// clock_gettime is POSIX, not C99, and only the stats need it.
+#define _POSIX_C_SOURCE 200809L
+
+#include "bitboard.h"
+#include "peers.h"
+#include "wfc.h"
+
+// Every bit of counting goes through these, so a build without the stats
+// doesn't have any of it (see SOLVER_STATS).
+#if SOLVER_STATS
+#include <time.h>
+
+#define ADD_STAT(board, field, amount) ((board)->stats.field += (amount))
+#define PEAK_STAT(board, field, value) \
+    ((board)->stats.field = (value) > (board)->stats.field ? (value) : (board)->stats.field)
+
+static uint64_t get_stats_time(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+#define START_TIMER(timer) uint64_t timer = get_stats_time()
+#define STOP_TIMER(board, field, timer) ADD_STAT(board, field, get_stats_time() - (timer))
+#else
+#define ADD_STAT(board, field, amount) ((void) 0)
+#define PEAK_STAT(board, field, value) ((void) 0)
+#define START_TIMER(timer) ((void) 0)
+#define STOP_TIMER(board, field, timer) ((void) 0)
+#endif
+
+// The peers of every tile, and the tiles in every house, as bitboards.
+// These can't be written out by the preprocessor the way the peer table is,
+// so init_tables builds them from it the first time a board is reset.
+static Bitboard peer_boards[BOARD_SIZE];
+static Bitboard house_boards[HOUSE_COUNT];
+static Bitboard all_tiles_board;
+
+// The tiles in every house: the rows, then the columns, then the boxes.
+static TileIndex house_tiles[HOUSE_COUNT][BOARD_WIDTH];
+
+// 0 before the tables are built, 1 while they're being built, 2 after.
+static int tables_state = 0;
+
+static void build_tables(void) {
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        for (int k = 0; k < PEER_COUNT; ++k) bitboard_set(&peer_boards[i], peers[i][k]);
+
+        int row = i / BOARD_WIDTH;
+        int column = i % BOARD_WIDTH;
+        int box = row / BOX_WIDTH * BOX_WIDTH + column / BOX_WIDTH;
+        int houses[3] = { row, BOARD_WIDTH + column, BOARD_WIDTH * 2 + box };
+        int positions[3] = {
+            column, row,
+            row % BOX_WIDTH * BOX_WIDTH + column % BOX_WIDTH
+        };
+        for (int h = 0; h < 3; ++h) {
+            bitboard_set(&house_boards[houses[h]], i);
+            house_tiles[houses[h]][positions[h]] = (TileIndex) i;
+        }
+        bitboard_set(&all_tiles_board, i);
+    }
+}
+
+// Build the tables exactly once, even if several threads
+// reset their first board at the same time.
+static void init_tables(void) {
+    if (__atomic_load_n(&tables_state, __ATOMIC_ACQUIRE) == 2) return;
+
+    int expected = 0;
+    if (__atomic_compare_exchange_n(&tables_state, &expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        build_tables();
+        __atomic_store_n(&tables_state, 2, __ATOMIC_RELEASE);
+        return;
+    }
+
+    // Another thread got there first.
+    while (__atomic_load_n(&tables_state, __ATOMIC_ACQUIRE) != 2) {}
+}
+
+// Advance the generator and return the next 32 random bits.
+static uint32_t next_random(Random *random) {
+    uint64_t old_state = random->state;
+    random->state = old_state * 6364136223846793005ULL + random->increment;
+
+    // Permute the old state into the output (XSH RR).
+    uint32_t xorshifted = (uint32_t) (((old_state >> 18) ^ old_state) >> 27);
+    uint32_t rotation = (uint32_t) (old_state >> 59);
+    return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+}
+
+void seed_random(Random *random, uint64_t seed, uint64_t stream) {
+    // The increment has to be odd, which is why the stream is shifted.
+    random->state = 0;
+    random->increment = (stream << 1) | 1;
+    next_random(random);
+    random->state += seed;
+    next_random(random);
+}
+
+int get_random_value(Random *random, int min, int max) {
+    return min + (int) (next_random(random) % (uint32_t) (max - min + 1));
+}
+
+void add_solver_stats(SolverStats *stats, const SolverStats *other) {
+    stats->constrains += other->constrains;
+    stats->collapses += other->collapses;
+    stats->solves += other->solves;
+    stats->removals += other->removals;
+    stats->propagations += other->propagations;
+    stats->backtracks += other->backtracks;
+    stats->restarts += other->restarts;
+    if (other->peak_trail_size > stats->peak_trail_size) stats->peak_trail_size = other->peak_trail_size;
+    if (other->peak_depth > stats->peak_depth) stats->peak_depth = other->peak_depth;
+    stats->select_time += other->select_time;
+    stats->propagate_time += other->propagate_time;
+    for (int depth = 0; depth < CASCADE_DEPTHS; ++depth) {
+        stats->cascade_depths[depth] += other->cascade_depths[depth];
+    }
+}
+
+static void add_to_bucket(Board *board, int i, int entropy) {
+    int position = board->bucket_sizes[entropy]++;
+    board->entropy_buckets[entropy][position] = (TileIndex) i;
+    board->bucket_positions[i] = (TileIndex) position;
+}
+
+static void remove_from_bucket(Board *board, int i, int entropy) {
+    // Fill the hole with the last tile in the bucket,
+    // so removal doesn't have to shift anything.
+    int position = board->bucket_positions[i];
+    int last = board->entropy_buckets[entropy][--board->bucket_sizes[entropy]];
+    board->entropy_buckets[entropy][position] = (TileIndex) last;
+    board->bucket_positions[last] = (TileIndex) position;
+}
+
+// Change the superpositions of a tile,
+// moving it to the bucket for its new entropy.
+// Every write to the tiles has to go through here to keep the buckets valid.
+static void write_tile(Board *board, int i, Tile mask) {
+    int old_entropy = board->entropies[i];
+    int new_entropy = count_values(mask);
+
+    // Move the tile in or out of the board of every value that changed.
+    uint64_t bit = (uint64_t) 1 << (i % 64);
+    for (unsigned int changed = board->tiles[i] ^ mask; changed; changed &= changed - 1) {
+        board->value_boards[lowest_bit(changed)].words[i / 64] ^= bit;
+    }
+    board->changed_tiles.words[i / 64] |= bit;
+    board->tiles[i] = mask;
+
+    if (old_entropy == new_entropy) return;
+    if (old_entropy == 1 || new_entropy == 1) board->collapsed_tiles.words[i / 64] ^= bit;
+    board->entropies[i] = (uint8_t) new_entropy;
+    remove_from_bucket(board, i, old_entropy);
+    add_to_bucket(board, i, new_entropy);
+}
+
+// Change the superpositions of a tile,
+// recording the old ones on the trail so the change can be rolled back.
+static void set_tile(Board *board, int i, Tile mask) {
+    board->trail[board->trail_size++] = (TrailEntry) { (TileIndex) i, board->tiles[i] };
+    PEAK_STAT(board, peak_trail_size, board->trail_size);
+    write_tile(board, i, mask);
+}
+
+// Reset all tiles to be a superposition of every value.
+void reset_tiles(Board *board) {
+    init_tables();
+
+    // ALL_VALUES sets the first TILE_STATES bits to 1 (0x1FF on a 9x9 board).
+    // This indicates that the tile can be any number.
+    // Every tile starts out in the bucket for the highest entropy,
+    // and on the board of every value.
+    for (int e = 0; e < TILE_STATES; ++e) board->bucket_sizes[e] = 0;
+    board->bucket_sizes[TILE_STATES] = BOARD_SIZE;
+    for (int i = 0; i < BOARD_SIZE; ++i) {
+        board->tiles[i] = ALL_VALUES;
+        board->entropies[i] = TILE_STATES;
+        board->entropy_buckets[TILE_STATES][i] = (TileIndex) i;
+        board->bucket_positions[i] = (TileIndex) i;
+    }
+    for (int v = 0; v < TILE_STATES; ++v) board->value_boards[v] = all_tiles_board;
+    board->changed_tiles = all_tiles_board;
+    board->collapsed_tiles = (Bitboard) { { 0 } };
+
+    // There is nothing to undo on a fresh board.
+    board->trail_size = 0;
+    board->undo_size = 0;
+}
+
+void rollback_tiles(Board *board, int trail_size) {
+    // Restore the recorded masks newest first,
+    // so a tile that changed several times ends up with its oldest mask.
+    while (board->trail_size > trail_size) {
+        TrailEntry entry = board->trail[--board->trail_size];
+        write_tile(board, entry.tile, entry.mask);
+    }
+
+    // Forget any collapses that were just rolled back.
+    while (board->undo_size && board->undo_marks[board->undo_size - 1] >= trail_size) {
+        --board->undo_size;
+    }
+}
+
+void undo_tiles(Board *board) {
+    if (board->undo_size) rollback_tiles(board, board->undo_marks[board->undo_size - 1]);
+}
+
+// Get a pointer to a tile at a given position.
+// The tile is read-only, changes have to go through set_tile.
+const Tile *get_tile(Board *board, int x, int y) {
+    // The tiles are stored in a 1D array.
+    // Multiplying by BOARD_WIDTH gets the row,
+    // and adding the column gets the 1D index of the tile.
+    return &board->tiles[y * BOARD_WIDTH + x];
+}
+
+// Check if a specific bit in a tile is set.
+bool is_set(Board *board, int x, int y, int bit) {
+    return *get_tile(board, x, y) & (1u << bit);
+}
+
+// The entropy of a tile is the number of superpositions it has.
+// This is the number of bits set in the tile's integer value,
+// which set_tile counts once whenever the tile changes.
+// This function doesnt take x and y because
+// it makes iterating through the tiles slightly easier (see solve_board).
+int get_tile_entropy(Board *board, int i) {
+    return board->entropies[i];
+}
+
+int get_board_entropy(Board *board) {
+    // Every tile in a bucket contributes that bucket's entropy.
+    int entropy = 0;
+    for (int e = 1; e <= TILE_STATES; ++e) {
+        entropy += e * board->bucket_sizes[e];
+    }
+    return entropy;
+}
+
+// Check if a tile's superpositions only contain one value.
+bool is_collapsed(Board *board, int x, int y) {
+    return board->entropies[x + y * BOARD_WIDTH] == 1;
+}
+
+// Get the value of a collapsed tile.
+int get_collapsed_value(Board *board, int x, int y) {
+    unsigned int value = *get_tile(board, x, y);
+    // This mask is the first TILE_STATES bits set to 1.
+    // This is used because the integer value can be larger than TILE_STATES
+    // bits and if it is, anything above them should be ignored.
+    unsigned int mask = ALL_VALUES;
+
+    // A collapsed tile only has one bit set,
+    // so the index of the lowest set bit is its value.
+    return lowest_bit(value & mask);
+}
+
+// Remove a superposition from a tile, without propagating it yet.
+// If that collapses the tile, it's queued so propagate can constrain its peers.
+// A tile can only collapse once, so it's never queued twice in one wave.
+// Returns false if the tile is left without any superpositions.
+static bool remove_superposition(Board *board, int i, int value) {
+    if (!(board->tiles[i] & (1u << value))) return true;
+    set_tile(board, i, (Tile) (board->tiles[i] & ~(1u << value)));
+    ADD_STAT(board, removals, 1);
+
+    if (board->entropies[i] == 0) return false;
+    if (board->entropies[i] == 1) board->propagation_queue[board->queue_size++] = (TileIndex) i;
+    return true;
+}
+
+// Remove a superposition from every peer of a tile.
+// Collapsed tiles are constrained too, because a collapsed peer
+// with the same value is exactly the contradiction to look for.
+// Only the peers that still have the value are visited,
+// which one AND of the value's board with the tile's peers finds.
+static bool remove_from_peers(Board *board, int i, int value) {
+    Bitboard affected = bitboard_and(&board->value_boards[value], &peer_boards[i]);
+    for (int word = 0; word < BITBOARD_LANES * 2; ++word) {
+        for (uint64_t bits = affected.words[word]; bits; bits &= bits - 1) {
+            int peer = word * 64 + lowest_bit64(bits);
+            if (!remove_superposition(board, peer, value)) return false;
+        }
+    }
+    return true;
+}
+
+// Constrain the peers of every queued tile until the queue runs dry,
+// which may queue more tiles as they collapse in turn.
+// The queue is always left empty, even when this runs into a contradiction.
+static bool propagate(Board *board, bool constrained) {
+#if SOLVER_STATS
+    // The queue is in the order the tiles collapsed, so each generation
+    // of the cascade ends where the queue did when the one before started.
+    int depth = 0;
+    int generation_end = 0;
+#endif
+
+    for (int head = 0; constrained && head < board->queue_size; ++head) {
+#if SOLVER_STATS
+        if (head == generation_end) {
+            ++depth;
+            generation_end = board->queue_size;
+        }
+#endif
+        int i = board->propagation_queue[head];
+        int value = lowest_bit((unsigned int) board->tiles[i]);
+        constrained = remove_from_peers(board, i, value);
+    }
+
+    ADD_STAT(board, propagations, board->queue_size);
+#if SOLVER_STATS
+    ++board->stats.cascade_depths[depth < CASCADE_DEPTHS ? depth : CASCADE_DEPTHS - 1];
+#endif
+
+    board->queue_size = 0;
+    return constrained;
+}
+
+// Remove a superposition from a tile
+// by unsetting the bit at the index of the value.
+// Returns false if that leaves the tile, or one of the tiles
+// the change propagates to, without any superpositions (a contradiction).
+bool constrain_tile(Board *board, int x, int y, int value) {
+    ADD_STAT(board, constrains, 1);
+    return propagate(board, remove_superposition(board, y * BOARD_WIDTH + x, value));
+}
+
+// Constrain a tile's peers by removing a superposition.
+// Returns false as soon as any of them runs into a contradiction.
+bool constrain_peers(Board *board, int x, int y, int value) {
+    return propagate(board, remove_from_peers(board, y * BOARD_WIDTH + x, value));
+}
+
+// Collapse a tile to a single value.
+// Returns false if the collapse leads to a contradiction,
+// including when the value isn't one of the tile's superpositions.
+bool collapse_tile(Board *board, int x, int y, int value) {
+    int i = y * BOARD_WIDTH + x;
+    ADD_STAT(board, collapses, 1);
+    if (!is_set(board, x, y, value)) return false;
+
+    // Remember where to roll back to for undo.
+    // A tile that's already collapsed has nothing to undo.
+    if (board->entropies[i] > 1) board->undo_marks[board->undo_size++] = board->trail_size;
+
+    // Set the tile to only contain the collapsed value.
+    Tile collapsed = (Tile) (1u << value);
+    if (board->tiles[i] != collapsed) set_tile(board, i, collapsed);
+
+    // Constrain the superpositions of the tile's in the same
+    // row, column, and box to not contain the collapsed value.
+    return constrain_peers(board, x, y, value);
+}
+
+// The passes. Each one goes over the board once, making every change it
+// finds without propagating them, and returns false on a contradiction.
+// run_passes propagates after each of them, and keeps running them
+// for as long as any of them changes a tile.
+
+// Collapse every tile that's the only place left for a value in one of its
+// houses (a hidden single). Only the houses that changed since the last pass
+// and still have open tiles are gone through, which the bitboards pick out
+// with one AND each, and that's about half of them.
+// Returns false if a value has no place left at all in some house.
+static bool collapse_hidden_singles(Board *board) {
+    // The pass's own collapses are changes for the next one to look at.
+    Bitboard changed = board->changed_tiles;
+    board->changed_tiles = (Bitboard) { { 0 } };
+
+    for (int h = 0; h < HOUSE_COUNT; ++h) {
+        Bitboard house_changes = bitboard_and(&changed, &house_boards[h]);
+        Bitboard open = bitboard_and_not(&house_boards[h], &board->collapsed_tiles);
+        if (bitboard_first(&house_changes) < 0 || bitboard_first(&open) < 0) continue;
+
+        // Work out which values appear in the house at least once,
+        // and which appear more than once, for all values at the same time.
+        Tile once = 0, twice = 0, placed = 0;
+        for (int k = 0; k < BOARD_WIDTH; ++k) {
+            int i = house_tiles[h][k];
+            Tile mask = board->tiles[i];
+            twice |= once & mask;
+            once |= mask;
+            if (board->entropies[i] == 1) placed |= mask;
+        }
+        // The houses after this one haven't been looked at, so every house
+        // is left for the next pass (which is after a rollback anyway).
+        if (once != ALL_VALUES) {
+            board->changed_tiles = all_tiles_board;
+            return false;
+        }
+
+        // The value board says which tile each remaining value is in.
+        for (unsigned int hidden = once & ~twice & ~placed; hidden; hidden &= hidden - 1) {
+            int value = lowest_bit(hidden);
+            Bitboard places = bitboard_and(&board->value_boards[value], &house_boards[h]);
+
+            // The tile may have just been collapsed to another hidden value.
+            int i = bitboard_first(&places);
+            if (i < 0) {
+                board->changed_tiles = all_tiles_board;
+                return false;
+            }
+
+            // Collapsing it here and letting propagate constrain its peers
+            // keeps the houses after this one correct.
+            set_tile(board, i, (Tile) (1u << value));
+            board->propagation_queue[board->queue_size++] = (TileIndex) i;
+        }
+    }
+
+    return true;
+}
+
+// Remove both values of every naked pair from the rest of its house.
+static bool remove_naked_pairs(Board *board) {
+    for (int h = 0; h < HOUSE_COUNT; ++h) {
+        for (int k = 0; k < BOARD_WIDTH; ++k) {
+            int i = house_tiles[h][k];
+            if (board->entropies[i] != 2) continue;
+
+            for (int other = k + 1; other < BOARD_WIDTH; ++other) {
+                int j = house_tiles[h][other];
+                if (board->tiles[j] != board->tiles[i]) continue;
+
+                Tile pair = board->tiles[i];
+                for (int rest = 0; rest < BOARD_WIDTH; ++rest) {
+                    int t = house_tiles[h][rest];
+                    if (t == i || t == j || !(board->tiles[t] & pair)) continue;
+
+                    for (unsigned int values = pair; values; values &= values - 1) {
+                        if (!remove_superposition(board, t, lowest_bit(values))) return false;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Remove a value from the tiles of a line outside of a box,
+// if all of the value's places in the box are on the line.
+static bool remove_pointing_value(Board *board, const Bitboard *places, int box, int line, int value) {
+    Bitboard outside = bitboard_and_not(places, &house_boards[line]);
+    if (bitboard_first(&outside) >= 0) return true;
+
+    Bitboard line_places = bitboard_and(&board->value_boards[value], &house_boards[line]);
+    Bitboard affected = bitboard_and_not(&line_places, &house_boards[box]);
+    for (int word = 0; word < BITBOARD_LANES * 2; ++word) {
+        for (uint64_t bits = affected.words[word]; bits; bits &= bits - 1) {
+            if (!remove_superposition(board, word * 64 + lowest_bit64(bits), value)) return false;
+        }
+    }
+    return true;
+}
+
+// Remove every value whose places in a box point along a row or column
+// from the rest of that row or column.
+static bool remove_pointing_pairs(Board *board) {
+    for (int box = BOARD_WIDTH * 2; box < HOUSE_COUNT; ++box) {
+        for (int value = 0; value < TILE_STATES; ++value) {
+            Bitboard places = bitboard_and(&board->value_boards[value], &house_boards[box]);
+            if (bitboard_count(&places) < 2) continue;
+
+            int i = bitboard_first(&places);
+            int row = i / BOARD_WIDTH;
+            int column = BOARD_WIDTH + i % BOARD_WIDTH;
+            if (!remove_pointing_value(board, &places, box, row, value)) return false;
+            if (!remove_pointing_value(board, &places, box, column, value)) return false;
+        }
+    }
+
+    return true;
+}
+
+// The passes, in the order of their bits.
+static const struct {
+    const char *name;
+    bool (*run)(Board *board);
+} pass_table[PASS_COUNT] = {
+    { "hidden-singles", collapse_hidden_singles },
+    { "naked-pairs", remove_naked_pairs },
+    { "pointing-pairs", remove_pointing_pairs },
+};
+
+const char *get_pass_name(int pass) {
+    return pass_table[pass].name;
+}
+
+// Run the passes the board has enabled until none of them find anything,
+// counting the changes each one makes by how much it grew the trail.
+static bool run_passes(Board *board) {
+    bool changed = board->passes != 0;
+    while (changed) {
+        changed = false;
+
+        for (int pass = 0; pass < PASS_COUNT; ++pass) {
+            if (!(board->passes & (1u << pass))) continue;
+
+            int trail_size = board->trail_size;
+            bool constrained = pass_table[pass].run(board);
+            board->pass_changes[pass] += board->trail_size - trail_size;
+            changed |= board->trail_size != trail_size;
+
+            if (!propagate(board, constrained)) return false;
+        }
+    }
+
+    return true;
+}
+
+// Check the buckets from the lowest entropy up.
+int get_lowest_entropy_tile(Board *board) {
+    for (int e = 2; e <= TILE_STATES; ++e) {
+        if (board->bucket_sizes[e]) return board->entropy_buckets[e][0];
+    }
+    return -1;
+}
+
+// The heuristics. Each selection returns the tile to collapse next,
+// or -1 if every tile has been collapsed, and each ordering returns
+// which of a frame's remaining values (of which there's at least one) to try next.
+
+static int select_lowest_entropy(Board *board, Random *random) {
+    (void) random;
+    return get_lowest_entropy_tile(board);
+}
+
+static int select_highest_degree(Board *board, Random *random) {
+    (void) random;
+    for (int e = 2; e <= TILE_STATES; ++e) {
+        int best = -1;
+        int best_degree = -1;
+        for (int k = 0; k < board->bucket_sizes[e]; ++k) {
+            int i = board->entropy_buckets[e][k];
+            int degree = 0;
+            for (int p = 0; p < PEER_COUNT; ++p) degree += board->entropies[peers[i][p]] > 1;
+            if (degree > best_degree) {
+                best = i;
+                best_degree = degree;
+            }
+        }
+        if (best >= 0) return best;
+    }
+    return -1;
+}
+
+// Every tile weighs WEIGHT_FACTOR times less for every superposition it has
+// over the tile with the least entropy, so one random number below the
+// total weight picks both the bucket and the tile in it.
+// Halving the weight isn't enough: so many more tiles have a high entropy
+// that the search would still take one often, and end up backtracking for
+// a very long time. The shift bottoms out before the weights can overflow.
+#define WEIGHT_SHIFT (3)
+#define MAX_WEIGHT_SHIFT (48)
+
+static int get_weight_shift(int entropy, int lowest) {
+    int shift = MAX_WEIGHT_SHIFT - WEIGHT_SHIFT * (entropy - lowest);
+    return shift > 0 ? shift : 0;
+}
+
+static int select_weighted(Board *board, Random *random) {
+    int lowest = 2;
+    while (lowest <= TILE_STATES && !board->bucket_sizes[lowest]) ++lowest;
+    if (lowest > TILE_STATES) return -1;
+
+    uint64_t total = 0;
+    for (int e = lowest; e <= TILE_STATES; ++e) {
+        total += (uint64_t) board->bucket_sizes[e] << get_weight_shift(e, lowest);
+    }
+
+    uint64_t pick = (((uint64_t) next_random(random) << 32) | next_random(random)) % total;
+    for (int e = lowest; e <= TILE_STATES; ++e) {
+        int shift = get_weight_shift(e, lowest);
+        uint64_t weight = (uint64_t) board->bucket_sizes[e] << shift;
+        if (pick < weight) return board->entropy_buckets[e][pick >> shift];
+        pick -= weight;
+    }
+    return -1;
+}
+
+// The first remaining value from the start up, wrapping around.
+static int order_from_start(Board *board, const SearchFrame *frame) {
+    (void) board;
+    unsigned int after = frame->remaining & ~((1u << frame->start) - 1);
+    return lowest_bit(after ? after : frame->remaining);
+}
+
+static int order_least_constraining(Board *board, const SearchFrame *frame) {
+    int best = -1;
+    int best_count = BOARD_SIZE;
+    for (int k = 0; k < TILE_STATES; ++k) {
+        int value = (frame->start + k) % TILE_STATES;
+        if (!(frame->remaining & (1u << value))) continue;
+
+        Bitboard places = bitboard_and(&board->value_boards[value], &peer_boards[frame->tile]);
+        int count = bitboard_count(&places);
+        if (count < best_count) {
+            best = value;
+            best_count = count;
+        }
+    }
+    return best;
+}
+
+static const struct {
+    const char *name;
+    int (*select)(Board *board, Random *random);
+} selection_table[SELECTION_COUNT] = {
+    { "mrv", select_lowest_entropy },
+    { "degree", select_highest_degree },
+    { "weighted", select_weighted },
+};
+
+static const struct {
+    const char *name;
+    int (*next)(Board *board, const SearchFrame *frame);
+} ordering_table[ORDERING_COUNT] = {
+    { "random", order_from_start },
+    { "lcv", order_least_constraining },
+};
+
+const char *get_selection_name(int selection) {
+    return selection_table[selection].name;
+}
+
+const char *get_ordering_name(int ordering) {
+    return ordering_table[ordering].name;
+}
+
+// Start the search over from the board it started on, after the passes.
+// The random number generator has moved on, so it picks other values.
+static void restart_search(Board *board, SolveState *solve) {
+    rollback_tiles(board, board->search_frames[0].trail_size);
+    solve->depth = 0;
+    solve->picking = true;
+    solve->restart_limit *= 2;
+    solve->restart_at = solve->backtracks + solve->restart_limit;
+    ADD_STAT(board, restarts, 1);
+}
+
+// Picking a tile, trying one of its values, and backing up a level
+// when it runs out of them are all one step, so a step never does more
+// than one collapse (and what it propagates to).
+static SolveStatus step_solve(Board *board, SolveState *solve, Random *random) {
+    if (solve->picking) {
+        // If every tile has an entropy of 1,
+        // every tile has been collapsed to a single value, and the board is solved.
+        START_TIMER(select_start);
+        int tile = selection_table[board->selection].select(board, random);
+        STOP_TIMER(board, select_time, select_start);
+        if (tile < 0) return SOLVE_SOLVED;
+
+        board->search_frames[solve->depth++] = (SearchFrame) {
+            .tile = tile,
+            .trail_size = board->trail_size,
+            .start = get_random_value(random, 0, TILE_STATES - 1),
+            .remaining = board->tiles[tile],
+        };
+        PEAK_STAT(board, peak_depth, solve->depth);
+        solve->picking = false;
+    }
+
+    // Try the tile's next value, and pick another tile
+    // if it collapses without a contradiction.
+    SearchFrame *frame = &board->search_frames[solve->depth - 1];
+    int x = frame->tile % BOARD_WIDTH;
+    int y = frame->tile / BOARD_WIDTH;
+    if (frame->remaining) {
+        int value = ordering_table[board->ordering].next(board, frame);
+        frame->remaining &= (Tile) ~(1u << value);
+
+        START_TIMER(propagate_start);
+        solve->picking = collapse_tile(board, x, y, value) && run_passes(board);
+        STOP_TIMER(board, propagate_time, propagate_start);
+        if (!solve->picking) {
+            rollback_tiles(board, frame->trail_size);
+            if (++solve->backtracks == solve->restart_at) restart_search(board, solve);
+        }
+        return SOLVE_RUNNING;
+    }
+
+    // None of this tile's values worked out,
+    // so the value picked for the tile above it was wrong too.
+    if (--solve->depth == 0) {
+        rollback_tiles(board, solve->start_trail_size);
+        return SOLVE_FAILED;
+    }
+    rollback_tiles(board, board->search_frames[solve->depth - 1].trail_size);
+    if (++solve->backtracks == solve->restart_at) restart_search(board, solve);
+    return SOLVE_RUNNING;
+}
+
+// Record how the solve went on the board once it's over.
+static SolveStatus finish_solve(Board *board, SolveState *solve, SolveStatus status) {
+    solve->status = status;
+    board->backtracks = solve->backtracks;
+    ADD_STAT(board, backtracks, solve->backtracks);
+    return status;
+}
+
+SolveStatus start_solve(Board *board, SolveState *solve) {
+    solve->depth = 0;
+    solve->backtracks = 0;
+    solve->picking = true;
+    solve->status = SOLVE_RUNNING;
+    solve->restart_at = RESTART_BACKTRACKS;
+    solve->restart_limit = RESTART_BACKTRACKS;
+
+    board->backtracks = 0;
+    for (int pass = 0; pass < PASS_COUNT; ++pass) board->pass_changes[pass] = 0;
+    ADD_STAT(board, solves, 1);
+
+    // A tile with no superpositions left can never be collapsed.
+    solve->start_trail_size = board->trail_size;
+    if (board->bucket_sizes[0]) return finish_solve(board, solve, SOLVE_FAILED);
+
+    // The passes may already be able to collapse some tiles.
+    START_TIMER(passes_start);
+    bool passed = run_passes(board);
+    STOP_TIMER(board, propagate_time, passes_start);
+    if (!passed) {
+        rollback_tiles(board, solve->start_trail_size);
+        return finish_solve(board, solve, SOLVE_FAILED);
+    }
+
+    return SOLVE_RUNNING;
+}
+
+SolveStatus continue_solve(Board *board, SolveState *solve, Random *random, long steps) {
+    for (long step = 0; solve->status == SOLVE_RUNNING && step < steps; ++step) {
+        SolveStatus status = step_solve(board, solve, random);
+        if (status != SOLVE_RUNNING) finish_solve(board, solve, status);
+    }
+    return solve->status;
+}
+
+// Solve the board by repeatedly collapsing the tile with the least entropy,
+// backtracking whenever that leads to a contradiction.
+// Entropy, in this case, is the number of superpositions a tile has.
+// This is a depth first search over the values of each tile,
+// starting from a random one, kept on an explicit stack instead of recursing.
+// It's the same search as a resumable solve, just run to the end at once.
+bool solve_board(Board *board, Random *random) {
+    SolveState solve;
+    SolveStatus status = start_solve(board, &solve);
+    while (status == SOLVE_RUNNING) status = step_solve(board, &solve, random);
+    if (solve.status == SOLVE_RUNNING) finish_solve(board, &solve, status);
+    return status == SOLVE_SOLVED;
+}
+
+// Count the board's solutions with the same search as solve_board,
+// trying every value in order and carrying on past each solution.
+// The board ends up as it was, since every collapse is on the trail.
+int count_solutions(Board *board, int limit) {
+    SearchFrame *frames = board->search_frames;
+    int depth = 0;
+    int solutions = 0;
+
+    if (board->bucket_sizes[0]) return 0;
+
+    int start_trail_size = board->trail_size;
+    if (!run_passes(board)) {
+        rollback_tiles(board, start_trail_size);
+        return 0;
+    }
+
+    while (true) {
+        int tile = get_lowest_entropy_tile(board);
+        if (tile >= 0) {
+            frames[depth++] = (SearchFrame) {
+                .tile = tile,
+                .trail_size = board->trail_size,
+                .remaining = board->tiles[tile],
+            };
+        } else if (++solutions >= limit) {
+            break;
+        }
+
+        // Move on to the next value of the deepest tile that has one left,
+        // which is the first value of a tile that was just found.
+        bool collapsed = false;
+        while (depth && !collapsed) {
+            SearchFrame *frame = &frames[depth - 1];
+            int x = frame->tile % BOARD_WIDTH;
+            int y = frame->tile / BOARD_WIDTH;
+            rollback_tiles(board, frame->trail_size);
+
+            while (frame->remaining && !collapsed) {
+                int value = lowest_bit(frame->remaining);
+                frame->remaining &= (Tile) (frame->remaining - 1);
+
+                collapsed = collapse_tile(board, x, y, value) && run_passes(board);
+                if (!collapsed) rollback_tiles(board, frame->trail_size);
+            }
+            if (!collapsed) --depth;
+        }
+
+        // Every value of every tile has been tried.
+        if (!collapsed) break;
+    }
+
+    rollback_tiles(board, start_trail_size);
+    return solutions;
+}
@@ -0,0 +1,426 @@
+#ifndef WFC_H
+#define WFC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The board is BOARD_ORDER by BOARD_ORDER boxes of BOARD_ORDER by BOARD_ORDER
+// tiles, so the usual 9x9 board has an order of 3. Build with -DBOARD_ORDER=4
+// for 16x16 boards, or -DBOARD_ORDER=5 for 25x25 boards.
+// Every order is its own build, with the tile masks, the tile indices and
+// the tables all sized for it, so a 9x9 board never pays for a bigger one.
+#ifndef BOARD_ORDER
+#define BOARD_ORDER (3)
+#endif
+
+#if BOARD_ORDER < 3 || BOARD_ORDER > 5
+#error "BOARD_ORDER has to be 3, 4 or 5"
+#endif
+
+// Each box is BOX_WIDTH tiles wide, and so is every row and column.
+#define BOX_WIDTH (BOARD_ORDER)
+#define BOARD_WIDTH (BOX_WIDTH * BOX_WIDTH)
+#define BOARD_SIZE (BOARD_WIDTH * BOARD_WIDTH)
+
+// Sudoku tiles have a possible state for every value in a row,
+// which is 9 of them on a 9x9 board.
+#define TILE_STATES (BOARD_WIDTH)
+
+// The integer type each tile's superpositions are stored in.
+// It only needs TILE_STATES bits, and the smaller it is the more boards
+// fit in the cache: with uint16_t the tiles of a 9x9 board take 162 bytes,
+// three cache lines. Build with -DTILE_TYPE=uint32_t to use 32 bits.
+// 25x25 boards need 25 bits, and always default to uint32_t.
+#ifndef TILE_TYPE
+#if BOARD_ORDER <= 4
+#define TILE_TYPE uint16_t
+#else
+#define TILE_TYPE uint32_t
+#endif
+#endif
+typedef TILE_TYPE Tile;
+
+// The integer type the index of a tile is stored in, in the tables,
+// the trail and the queues. Boards bigger than 16x16 need more than a byte.
+#if BOARD_SIZE <= 256
+typedef uint8_t TileIndex;
+#else
+typedef uint16_t TileIndex;
+#endif
+
+// Every value of a tile, which is what a tile is reset to.
+#define ALL_VALUES ((Tile) ((1u << TILE_STATES) - 1))
+
+// Fails to compile if the tile type is too small for every superposition.
+typedef char tile_type_check[sizeof(Tile) * 8 >= TILE_STATES ? 1 : -1];
+
+// Bit counting for the tile masks, using the compiler's intrinsics
+// when it has them. lowest_bit is undefined for a mask of 0.
+// GCC and Clang only inline __builtin_popcount when the target has a
+// popcount instruction (x86 needs -mpopcnt or -march, see POPCNT in the
+// Makefile), otherwise it becomes a library call that's slower than
+// counting by hand.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || defined(__aarch64__))
+static inline int count_bits(unsigned int mask) { return __builtin_popcount(mask); }
+#elif defined(_MSC_VER) && defined(__AVX__)
+#include <intrin.h>
+static inline int count_bits(unsigned int mask) { return (int) __popcnt(mask); }
+#else
+static inline int count_bits(unsigned int mask) {
+    // Add up the bits in parallel, in pairs, then nibbles, then bytes.
+    mask = mask - ((mask >> 1) & 0x55555555u);
+    mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+    mask = (mask + (mask >> 4)) & 0x0F0F0F0Fu;
+    return (int) ((mask * 0x01010101u) >> 24);
+}
+#endif
+
+// The number of values in a tile's mask. Without a popcount instruction
+// a table of the bits in every 9 bit number beats counting them in
+// parallel, since a whole 9x9 tile is one load from it (and a 16x16 or
+// 25x25 tile two or three, which the loop unrolls to).
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || defined(__aarch64__)) \
+    || defined(_MSC_VER) && defined(__AVX__)
+static inline int count_values(Tile mask) { return count_bits((unsigned int) mask); }
+#else
+#define NINE_BIT_COUNTS2(n) n, n + 1, n + 1, n + 2
+#define NINE_BIT_COUNTS4(n) NINE_BIT_COUNTS2(n), NINE_BIT_COUNTS2(n + 1), NINE_BIT_COUNTS2(n + 1), NINE_BIT_COUNTS2(n + 2)
+#define NINE_BIT_COUNTS6(n) NINE_BIT_COUNTS4(n), NINE_BIT_COUNTS4(n + 1), NINE_BIT_COUNTS4(n + 1), NINE_BIT_COUNTS4(n + 2)
+#define NINE_BIT_COUNTS8(n) NINE_BIT_COUNTS6(n), NINE_BIT_COUNTS6(n + 1), NINE_BIT_COUNTS6(n + 1), NINE_BIT_COUNTS6(n + 2)
+static const uint8_t nine_bit_counts[512] = { NINE_BIT_COUNTS8(0), NINE_BIT_COUNTS8(1) };
+
+static inline int count_values(Tile mask) {
+    int count = 0;
+    for (int shift = 0; shift < TILE_STATES; shift += 9) count += nine_bit_counts[(mask >> shift) & 0x1FF];
+    return count;
+}
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+static inline int lowest_bit(unsigned int mask) { return __builtin_ctz(mask); }
+#elif defined(_MSC_VER)
+#include <intrin.h>
+static inline int lowest_bit(unsigned int mask) {
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int) index;
+}
+#else
+static inline int lowest_bit(unsigned int mask) {
+    int index = 0;
+    for (; !(mask & 1); mask >>= 1) ++index;
+    return index;
+}
+#endif
+
+// The solver itself lives in wfc.c so that it can be linked
+// without raylib (see headless.c), while sudoku_wfc.c only draws it.
+
+// Every row, column and box is a house, and each one has to end up
+// holding every value exactly once.
+#define HOUSE_COUNT (BOARD_WIDTH * 3)
+
+// A set of tiles, one bit per tile (bit i is tile i),
+// packed into 128-bit lanes so bitboard.h can work on them with SIMD.
+#define BITBOARD_LANES ((BOARD_SIZE + 127) / 128)
+typedef struct Bitboard {
+    uint64_t words[BITBOARD_LANES * 2];
+} Bitboard;
+
+// A PCG32 random number generator.
+// Each generator has its own state, so every thread can own one,
+// and the stream selects one of 2^63 independent sequences for the same seed.
+typedef struct Random {
+    uint64_t state;
+    uint64_t increment;
+} Random;
+
+// Seed a random number generator on the given stream.
+void seed_random(Random *random, uint64_t seed, uint64_t stream);
+
+// Get a random integer between min and max (both inclusive).
+int get_random_value(Random *random, int min, int max);
+
+// Every change to a tile can only remove superpositions,
+// so a tile can change at most TILE_STATES times before it's reset.
+#define TRAIL_CAPACITY (BOARD_SIZE * TILE_STATES)
+
+// A tile's superpositions from before a change,
+// so the change can be rolled back.
+typedef struct TrailEntry {
+    TileIndex tile;
+    Tile mask;
+} TrailEntry;
+
+// Extra propagation passes solve_board can run after every collapse,
+// on top of removing a collapsed tile's value from its peers.
+// Each pass is one bit of a board's passes, and they can be combined.
+// Hidden singles: collapse a tile that's the only place left for a value
+// in one of its houses.
+// Naked pairs: two tiles in a house with the same two superpositions
+// take both values, so the rest of the house can't have either.
+// Pointing pairs: if a value's places in a box are all in one row
+// (or column), the rest of that row can't have the value.
+#define PASS_COUNT (3)
+#define PASS_HIDDEN_SINGLES (1u << 0)
+#define PASS_NAKED_PAIRS (1u << 1)
+#define PASS_POINTING_PAIRS (1u << 2)
+#define PASS_ALL ((1u << PASS_COUNT) - 1)
+
+// The heuristics solve_board can pick the next tile to collapse with.
+// MRV (minimum remaining values): the tile with the least entropy.
+// Degree: the same, but of the tiles with the least entropy, the one with
+// the most uncollapsed peers, which constrains the most when it collapses.
+// Weighted: a random tile, where one superposition fewer makes a tile
+// eight times as likely, so the search still mostly goes for the least
+// entropy but two solves of the same puzzle take different paths.
+#define SELECTION_COUNT (3)
+#define SELECT_MRV (0)
+#define SELECT_DEGREE (1)
+#define SELECT_WEIGHTED (2)
+
+// The orders solve_board can try a tile's values in.
+// Random: starting from a random value, and going up from there.
+// LCV (least constraining value): the value the fewest peers still have
+// first, which leaves the peers the most superpositions (ties in the
+// random order).
+#define ORDERING_COUNT (2)
+#define ORDER_RANDOM (0)
+#define ORDER_LCV (1)
+
+// Build with -DSOLVER_STATS=1 (make SOLVER_STATS=1) to have every board
+// count what its solver does, for working out where the time goes.
+// The counting is compiled out otherwise, so it costs nothing at all,
+// not even the space in the board.
+#ifndef SOLVER_STATS
+#define SOLVER_STATS (0)
+#endif
+
+// Propagating a change is a cascade: the tiles it collapses constrain their
+// peers, which collapses more tiles, and so on. The depth of a cascade is
+// how many generations of collapses it went through, 0 if it collapsed none.
+// Cascades this deep or deeper are counted in the last bucket.
+#define CASCADE_DEPTHS (16)
+
+// What the solver did on a board. Every field only ever grows, until
+// the board's owner clears it, so it covers the board's whole life
+// and not just the last call to solve_board.
+typedef struct SolverStats {
+    // Calls to constrain_tile, collapse_tile and solve_board.
+    long constrains;
+    long collapses;
+    long solves;
+
+    // The superpositions removed from tiles, and the collapsed tiles
+    // whose peers were constrained while propagating.
+    long removals;
+    long propagations;
+
+    // The values solve_board had to take back,
+    // and the times it started over (see RESTART_BACKTRACKS).
+    long backtracks;
+    long restarts;
+
+    // The most trail entries and search levels in use at once,
+    // to check the capacities of the board against (see Board).
+    int peak_trail_size;
+    int peak_depth;
+
+    // The time solve_board spent picking the next tile to collapse,
+    // and collapsing it and propagating the constraints, in nanoseconds.
+    // Reading the clock takes a good part of that on a 9x9 board,
+    // so these are best compared with each other rather than with a
+    // build without the stats.
+    uint64_t select_time;
+    uint64_t propagate_time;
+
+    // The number of cascades of each depth.
+    long cascade_depths[CASCADE_DEPTHS];
+} SolverStats;
+
+// Add one set of stats to another. The peaks are the highest of the two.
+void add_solver_stats(SolverStats *stats, const SolverStats *other);
+
+// One level of the search: a tile and the values left to try for it,
+// which the order goes through starting from start.
+typedef struct SearchFrame {
+    int tile;
+    int trail_size;
+    int start;
+    Tile remaining;
+} SearchFrame;
+
+// All of the state for a single board.
+// Every solver function takes the board it works on explicitly,
+// so any number of boards can exist (and be solved) at the same time.
+// Everything a search needs is in here, sized for the worst case,
+// so solving never allocates: a board is all the memory its solver needs,
+// and resetting it (or starting a search on it) is all the clearing it needs.
+typedef struct Board {
+    // The tiles are each stored as an integer,
+    // with the first TILE_STATES bits representing its superpositions.
+    // If a bit is set, the tile is allowed to be that number.
+    Tile tiles[BOARD_SIZE];
+
+    // Every change made to the tiles since they were reset, oldest first.
+    // Rolling back pops entries and restores the masks they recorded.
+    TrailEntry trail[TRAIL_CAPACITY];
+    int trail_size;
+
+    // The trail size before each collapse, which is how far undo_tiles
+    // rolls back. A tile can only be collapsed once, so there can't be
+    // more of these than there are tiles.
+    int undo_marks[BOARD_SIZE];
+    int undo_size;
+
+    // The tiles grouped by entropy, so the tile with the least entropy
+    // can be found without sorting the board.
+    // entropy_buckets[e] holds the indices of the bucket_sizes[e] tiles
+    // with an entropy of e, in no particular order.
+    TileIndex entropy_buckets[TILE_STATES + 1][BOARD_SIZE];
+    int bucket_sizes[TILE_STATES + 1];
+
+    // Where each tile currently is in its bucket, for removal in O(1).
+    TileIndex bucket_positions[BOARD_SIZE];
+
+    // The entropy of every tile, kept up to date by set_tile,
+    // so checking a tile's entropy never has to count bits.
+    uint8_t entropies[BOARD_SIZE];
+
+    // For every value, the tiles that still have it as a superposition.
+    // These mirror the tiles, and are kept in sync by set_tile,
+    // so a value can be checked against a whole house at once.
+    Bitboard value_boards[TILE_STATES];
+
+    // The tiles set_tile has changed since the hidden singles pass last
+    // went through their houses. A house without any of them has the same
+    // tiles as when the pass last found nothing in it, so it's skipped.
+    Bitboard changed_tiles;
+
+    // The tiles that are collapsed, so the pass also skips houses that are
+    // full: they can't have a hidden single, and a value collapsed twice
+    // in one is found by propagate anyway. ENGINE_AUTO counts them too.
+    Bitboard collapsed_tiles;
+
+    // Tiles that collapsed while propagating a constraint,
+    // whose peers still have to be constrained. Only used during a change.
+    TileIndex propagation_queue[BOARD_SIZE];
+    int queue_size;
+
+    // The levels of the search solve_board (or count_solutions) is doing
+    // on the board, so only one of them can be going on at a time.
+    // Every level collapses one more tile, so the search can't go deeper than this.
+    SearchFrame search_frames[BOARD_SIZE];
+
+    // The PASS_ flags solve_board uses on this board,
+    // and the SELECT_ and ORDER_ heuristics. reset_tiles leaves them alone.
+    unsigned int passes;
+    int selection;
+    int ordering;
+
+    // The number of times the last call to solve_board had to backtrack.
+    long backtracks;
+
+    // The number of changes each pass made to the tiles during the last
+    // call to solve_board, not counting what they propagated to.
+    long pass_changes[PASS_COUNT];
+
+#if SOLVER_STATS
+    SolverStats stats;
+#endif
+} Board;
+
+void reset_tiles(Board *board);
+
+// Undo the last collapse, and everything it propagated to.
+// This can be repeated all the way back to the last reset.
+void undo_tiles(Board *board);
+
+// Roll the tiles back to how they were when the trail was this size.
+void rollback_tiles(Board *board, int trail_size);
+
+const Tile *get_tile(Board *board, int x, int y);
+bool is_set(Board *board, int x, int y, int bit);
+
+int get_tile_entropy(Board *board, int i);
+int get_board_entropy(Board *board);
+
+// Find the uncollapsed tile with the least entropy, which is the one
+// solve_board collapses next. Returns -1 if every tile has been collapsed.
+int get_lowest_entropy_tile(Board *board);
+
+bool is_collapsed(Board *board, int x, int y);
+int get_collapsed_value(Board *board, int x, int y);
+
+// These return false if they leave a tile with no superpositions,
+// which means the board can't be solved from its current state.
+bool constrain_tile(Board *board, int x, int y, int value);
+bool constrain_peers(Board *board, int x, int y, int value);
+bool collapse_tile(Board *board, int x, int y, int value);
+
+// The name of a pass (the index of its bit), such as "hidden-singles",
+// and of a selection or ordering heuristic, such as "degree" or "lcv".
+const char *get_pass_name(int pass);
+const char *get_selection_name(int selection);
+const char *get_ordering_name(int ordering);
+
+// Returns false (leaving the board as it was) if the board has no solution.
+// The random number generator picks the order values are tried in.
+bool solve_board(Board *board, Random *random);
+
+// After this many backtracks solve_board gives up on the values it has
+// picked and starts over (keeping what the passes found first), with
+// twice as many allowed each time so it still searches everything
+// in the end. One bad early value can leave a 16x16 or 25x25 board
+// backtracking for minutes where a restart solves it in milliseconds.
+// A 9x9 board never gets that far, so it only restarts when built with
+// -DRESTART_BACKTRACKS=n, and 0 never restarts.
+#ifndef RESTART_BACKTRACKS
+#if BOARD_ORDER >= 4
+#define RESTART_BACKTRACKS (1000)
+#else
+#define RESTART_BACKTRACKS (0)
+#endif
+#endif
+
+typedef enum SolveStatus {
+    SOLVE_RUNNING,
+    SOLVE_SOLVED,
+    SOLVE_FAILED,
+} SolveStatus;
+
+// The search solve_board does, kept outside of the call stack
+// so it can be stopped after any step and picked up again later,
+// like a frame at a time in the window. Between steps the board is
+// always in a consistent state, so it can be drawn (or undone) as it is.
+// The levels of the search are the board's search_frames.
+typedef struct SolveState {
+    int depth;
+
+    // Whether the last collapse worked out, so the next step picks a new tile.
+    bool picking;
+
+    int start_trail_size;
+    long backtracks;
+    SolveStatus status;
+
+    // The backtracks the search restarts at, and how many more
+    // the one after that is allowed.
+    long restart_at;
+    long restart_limit;
+} SolveState;
+
+// Start solving a board, which fails right away if the passes find
+// a contradiction. Every step collapses at most one tile, and the board
+// has to be left alone between steps. Once the solve is over,
+// the board's backtracks are set as if solve_board had solved it,
+// and with the same random numbers it ends up with the same solution.
+SolveStatus start_solve(Board *board, SolveState *solve);
+SolveStatus continue_solve(Board *board, SolveState *solve, Random *random, long steps);
+
+// Count the board's solutions, stopping as soon as there are `limit` of them,
+// so a limit of 2 is enough to tell if a puzzle's solution is unique.
+// The board is left as it was.
+int count_solutions(Board *board, int limit);
+
+#endif // WFC_H